@@ -0,0 +1,226 @@
+/** BINARY_FORMAT.cpp
+ * Implementation of the memory-mappable binary format of KCMC instances, and of the instance loader
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <cstring>    // memcmp, memcpy, strncpy
+#include <fstream>    // ifstream, ofstream
+#include <iostream>   // cin
+#include <stdexcept>  // runtime_error
+#include <string>     // string
+
+// POSIX dependencies
+#include <fcntl.h>     // open
+#include <unistd.h>    // close
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* #####################################################################################################################
+ * MEMORY-MAPPED FILES
+ */
+
+/** MAPPED FILE
+ * Read-only, shared memory mapping of a whole file. The pages are shared with every other process mapping the file
+ */
+MappedFile::MappedFile(const std::string &path) : address(nullptr), length(0) {
+    struct stat file_status;
+
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {throw std::runtime_error("UNABLE TO OPEN INSTANCE FILE " + path);}
+    if (fstat(descriptor, &file_status) != 0) {
+        close(descriptor);
+        throw std::runtime_error("UNABLE TO READ INSTANCE FILE " + path);
+    }
+    this->length = (size_t)(file_status.st_size);
+    if (this->length > 0) {
+        void *mapped = mmap(nullptr, this->length, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (mapped == MAP_FAILED) {
+            close(descriptor);
+            throw std::runtime_error("UNABLE TO MAP INSTANCE FILE " + path);
+        }
+        this->address = (const char *)mapped;
+    }
+    close(descriptor);  // The mapping stays valid after the descriptor is closed
+}
+
+MappedFile::~MappedFile() {
+    if (this->address != nullptr) {munmap((void *)(this->address), this->length);}
+}
+
+
+/** BINARY INSTANCE DETECTION
+ * A file is a binary instance if it starts with the binary format magic string
+ */
+bool is_binary_instance(const std::string &path) {
+    char magic[8] = {0};
+    std::ifstream file(path, std::ios::binary);
+    if (not file.read(magic, sizeof(magic))) {return false;}
+    return memcmp(magic, KCMC_BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+
+/* #####################################################################################################################
+ * BINARY INSTANCE WRITER & READER
+ */
+
+/** BINARY INSTANCE WRITER
+ * Writes the header and the CSR arrays of every adjacency of the instance
+ */
+void KCMC_Instance::write_binary(const std::string &path) {
+    KCMC_BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, KCMC_BINARY_MAGIC, sizeof(header.magic));
+    header.version = KCMC_BINARY_VERSION;
+    header.byte_order = KCMC_BINARY_BYTE_ORDER;
+    header.num_pois = this->num_pois;
+    header.num_sensors = this->num_sensors;
+    header.num_sinks = this->num_sinks;
+    header.area_side = this->area_side;
+    header.sensor_coverage_radius = this->sensor_coverage_radius;
+    header.sensor_communication_radius = this->sensor_communication_radius;
+    header.random_seed = this->random_seed;
+    header.num_poi_sensor = this->poi_sensor.num_edges();
+    header.num_sensor_sensor = this->sensor_sensor.num_edges();
+    header.num_sensor_sink = this->sensor_sink.num_edges();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (not out) {throw std::runtime_error("UNABLE TO WRITE INSTANCE FILE " + path);}
+    out.write((const char *)(&header), sizeof(header));
+    for (const CSR_Adjacency *adjacency : {&this->poi_sensor, &this->sensor_poi, &this->sensor_sensor,
+                                           &this->sensor_sink, &this->sink_sensor}) {
+        out.write((const char *)(adjacency->offsets()), sizeof(int) * (adjacency->num_sources() + 1));
+        out.write((const char *)(adjacency->neighbors()), sizeof(int) * adjacency->num_edges());
+    }
+    if (not out) {throw std::runtime_error("UNABLE TO WRITE INSTANCE FILE " + path);}
+}
+
+
+/** CSR ARRAYS VALIDATOR
+ * Checks that the mapped offsets of an adjacency start at 0, never decrease and end at its number of edges, and that
+ * each row holds increasing neighbors in [0, num_targets). So a corrupt file of the right size is never read out of
+ * bounds later on
+ */
+static void check_csr(const int *offsets, const int num_sources, const long long num_edges, const int num_targets,
+                      const std::string &name) {
+    int source, position;
+    if ((offsets[0] != 0) or (offsets[num_sources] != num_edges)) {
+        throw std::runtime_error("BINARY INSTANCE HAS INVALID " + name + " OFFSETS!");
+    }
+    const int *neighbors = offsets + num_sources + 1;
+    for (source=0; source < num_sources; source++) {
+        if (offsets[source+1] < offsets[source]) {
+            throw std::runtime_error("BINARY INSTANCE HAS INVALID " + name + " OFFSETS!");
+        }
+        for (position = offsets[source]; position < offsets[source+1]; position++) {
+            if ((neighbors[position] < 0) or (neighbors[position] >= num_targets)
+                or ((position > offsets[source]) and (neighbors[position] <= neighbors[position-1]))) {
+                throw std::runtime_error("BINARY INSTANCE HAS INVALID " + name + " NEIGHBORS!");
+            }
+        }
+    }
+}
+
+
+/** BINARY INSTANCE READER
+ * Validates the header and the CSR arrays of a mapped binary instance, copies its key fields and attaches the
+ * adjacencies to its arrays
+ */
+void KCMC_Instance::attach_binary(std::shared_ptr<MappedFile> binary_file) {
+    KCMC_BinaryHeader header;
+    size_t expected_size;
+    const int *cursor;
+
+    // Validate the header
+    if (binary_file->size() < sizeof(header)) {throw std::runtime_error("BINARY INSTANCE IS TRUNCATED!");}
+    memcpy(&header, binary_file->data(), sizeof(header));
+    if (memcmp(header.magic, KCMC_BINARY_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("INSTANCE DOES NOT STARTS WITH PREFIX 'KCMCBIN'");
+    }
+    if (header.version != KCMC_BINARY_VERSION) {throw std::runtime_error("UNSUPPORTED BINARY INSTANCE VERSION!");}
+    if (header.byte_order != KCMC_BINARY_BYTE_ORDER) {throw std::runtime_error("BINARY INSTANCE HAS FOREIGN BYTE ORDER!");}
+    if (header.num_pois <= 0) {throw std::runtime_error("INSTANCE HAS NO POIS!");}
+    if (header.num_sensors <= 0) {throw std::runtime_error("INSTANCE HAS NO SENSORS!");}
+    if (header.num_sinks <= 0) {throw std::runtime_error("INSTANCE HAS NO SINKS!");}
+    for (const int64_t &num_edges : {header.num_poi_sensor, header.num_sensor_sensor, header.num_sensor_sink}) {
+        if ((num_edges < 0) or (num_edges > INT32_MAX)) {throw std::runtime_error("BINARY INSTANCE HAS INVALID SIZE!");}
+    }
+    expected_size = sizeof(header) + sizeof(int) * (size_t)(
+        (header.num_pois + 1) + header.num_poi_sensor         // poi_sensor
+        + (header.num_sensors + 1) + header.num_poi_sensor    // sensor_poi
+        + (header.num_sensors + 1) + header.num_sensor_sensor // sensor_sensor
+        + (header.num_sensors + 1) + header.num_sensor_sink   // sensor_sink
+        + (header.num_sinks + 1) + header.num_sensor_sink);   // sink_sensor
+    if (binary_file->size() != expected_size) {throw std::runtime_error("BINARY INSTANCE HAS INVALID SIZE!");}
+
+    // Copy the key fields
+    this->num_pois = header.num_pois;
+    this->num_sensors = header.num_sensors;
+    this->num_sinks = header.num_sinks;
+    this->area_side = header.area_side;
+    this->sensor_coverage_radius = header.sensor_coverage_radius;
+    this->sensor_communication_radius = header.sensor_communication_radius;
+    this->random_seed = header.random_seed;
+
+    // Validate the arrays of each adjacency, right after the header, in the file order
+    cursor = (const int *)(binary_file->data() + sizeof(header));
+    check_csr(cursor, header.num_pois, header.num_poi_sensor, header.num_sensors, "POI-SENSOR");
+    cursor += (header.num_pois + 1) + header.num_poi_sensor;
+    check_csr(cursor, header.num_sensors, header.num_poi_sensor, header.num_pois, "SENSOR-POI");
+    cursor += (header.num_sensors + 1) + header.num_poi_sensor;
+    check_csr(cursor, header.num_sensors, header.num_sensor_sensor, header.num_sensors, "SENSOR-SENSOR");
+    cursor += (header.num_sensors + 1) + header.num_sensor_sensor;
+    check_csr(cursor, header.num_sensors, header.num_sensor_sink, header.num_sinks, "SENSOR-SINK");
+    cursor += (header.num_sensors + 1) + header.num_sensor_sink;
+    check_csr(cursor, header.num_sinks, header.num_sensor_sink, header.num_sensors, "SINK-SENSOR");
+
+    // Attach each adjacency to its arrays
+    cursor = (const int *)(binary_file->data() + sizeof(header));
+    this->poi_sensor.attach(this->num_pois, cursor, cursor + this->num_pois + 1);
+    cursor += (this->num_pois + 1) + header.num_poi_sensor;
+    this->sensor_poi.attach(this->num_sensors, cursor, cursor + this->num_sensors + 1);
+    cursor += (this->num_sensors + 1) + header.num_poi_sensor;
+    this->sensor_sensor.attach(this->num_sensors, cursor, cursor + this->num_sensors + 1);
+    cursor += (this->num_sensors + 1) + header.num_sensor_sensor;
+    this->sensor_sink.attach(this->num_sensors, cursor, cursor + this->num_sensors + 1);
+    cursor += (this->num_sensors + 1) + header.num_sensor_sink;
+    this->sink_sensor.attach(this->num_sinks, cursor, cursor + this->num_sinks + 1);
+
+    // Keep the mapping alive as long as the instance, and drop the artifacts of any previous graph
+    this->mapping = binary_file;
+    this->drop_derived();
+}
+
+
+/* #####################################################################################################################
+ * INSTANCE LOADER
+ */
+
+/** INSTANCE LOADER
+ * Serialized instances start with the prefix 'KCMC;'. The source "-" is a serialized instance in STDIN.
+ * Anything else is the path of a file, either a binary instance or a serialized instance
+ */
+KCMC_Instance *KCMC_Instance::load(const std::string &source) {
+    if (source.compare(0, 5, "KCMC;") == 0) {return new KCMC_Instance(source);}
+    if (source == "-") {return new KCMC_Instance(std::cin);}
+    if (not is_binary_instance(source)) {
+        std::ifstream file(source);
+        if (not file) {throw std::runtime_error("UNABLE TO OPEN INSTANCE FILE " + source);}
+        return new KCMC_Instance(file);
+    }
+
+    auto *instance = new KCMC_Instance();
+    try {
+        instance->attach_binary(std::make_shared<MappedFile>(source));
+        instance->compute_base_levels();
+    } catch (const std::exception &exc) {
+        delete instance;
+        throw;
+    }
+    return instance;
+}
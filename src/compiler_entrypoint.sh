@@ -7,6 +7,7 @@ cmake --build .
 # COPY THE OUTPUT EXECUTABLES TO THE BUILDS DIRECTORY
 cp instance_generator /app/builds
 cp instance_evaluator /app/builds
+cp instance_converter /app/builds
 cp placements_visualizer /app/builds
 cp optimizer* /app/builds
 chmod +x /app/builds/*
\ No newline at end of file
@@ -0,0 +1,206 @@
+/** CONNECTIVITY_CERTIFICATE.cpp
+ * Implementation of the certified connectivity services of the KCMC instance object, which keep the disjoint paths of
+ * each POI class between evaluations and re-route only the classes whose paths were broken
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::find, std::min, std::max
+#include <atomic>     // atomic
+#include <stdexcept>  // runtime_error
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* #####################################################################################################################
+ * CERTIFICATE UPDATE
+ */
+
+/** CERTIFY
+ * Brings the certificate up to date with the given set of inactive sensors, and returns the lowest class with fewer
+ *   paths than the limit (-1 if none). A certificate from another limit or connectivity method is started over.
+ * Only the sensors that differ from the certified set are inspected. A newly inactive sensor invalidates the classes
+ *   whose paths cross it, and any difference at all invalidates the classes below the limit, as they might now have
+ *   other paths. Greedy paths are only certified for the set they were found under, as a fresh greedy search on the
+ *   new level graph may find fewer of them, so any difference invalidates every class.
+ * The invalidated classes are then re-routed in parallel blocks, in class order. If stop, the blocks stop at the
+ *   first class below the limit, and the classes after it are left to be evaluated in a later call.
+ */
+int KCMC_Instance::certify(ConnectivityCertificate &certificate, const int limit, const SensorSet &inactive_sensors,
+                           const bool stop) {
+    inactive_sensors.require_width(this->num_sensors);
+    const PoiClasses &classes = this->poi_classes();
+    int a_class, bit, word_index, num_words = (int)inactive_sensors.words.size();
+    uint64_t difference;
+    bool changed = false;
+
+    // Start over, with every class to be evaluated, if the certificate is empty or from other settings
+    if ((certificate.method != connectivity_method) or (certificate.limit != limit)
+        or ((int)certificate.paths.size() != classes.size()) or (certificate.inactive.size() != this->num_sensors)) {
+        certificate.method = connectivity_method;
+        certificate.limit = limit;
+        certificate.inactive.resize(this->num_sensors);
+        certificate.paths.assign(classes.size(), -1);
+        certificate.used.assign(classes.size(), std::vector<int>());
+        certificate.users.assign(this->num_sensors, std::vector<int>());
+        certificate.level_graph.reset();
+        if (connectivity_method != CONN_EXACT) {certificate.level_graph.reset(new LevelGraph(this));}
+    }
+
+    // Toggle the sensors that differ, invalidating the classes that use each newly inactive sensor
+    for (word_index=0; word_index < num_words; word_index++) {
+        difference = certificate.inactive.words[word_index] ^ inactive_sensors.words[word_index];
+        while (difference != 0) {
+            bit = (word_index * 64) + __builtin_ctzll(difference);
+            difference &= difference - 1;
+            if (bit >= this->num_sensors) {break;}  // Stray bits past the last sensor are ignored
+            changed = true;
+            if (certificate.inactive.contains(bit)) {certificate.inactive.erase(bit); continue;}
+            certificate.inactive.insert(bit);
+            for (const int &user : certificate.users[bit]) {certificate.paths[user] = -1;}
+        }
+    }
+    if (changed) {
+        for (int &paths : certificate.paths) {
+            if ((paths < limit) or (certificate.method != CONN_EXACT)) {paths = -1;}
+        }
+        if (certificate.level_graph) {certificate.level_graph->sync(certificate.inactive);}
+    }
+
+    // Invalidated classes, forgetting their paths
+    std::vector<int> invalid;
+    for (a_class=0; a_class < classes.size(); a_class++) {
+        if (certificate.paths[a_class] != -1) {continue;}
+        invalid.push_back(a_class);
+        for (const int &a_sensor : certificate.used[a_class]) {
+            std::vector<int> &users = certificate.users[a_sensor];
+            auto position = std::find(users.begin(), users.end(), a_class);
+            if (position != users.end()) {*position = users.back(); users.pop_back();}
+        }
+        certificate.used[a_class].clear();
+    }
+
+    // Re-route the invalidated classes, each thread over its block in class order
+    if (not invalid.empty()) {
+        int threads = std::max(1, std::min(num_threads, (int)invalid.size()));
+        std::unique_ptr<ConnectivityScratch> scratch = this->lease_scratch();
+        if ((int)scratch->paths.size() < threads) {scratch->paths.resize(threads);}
+        if (certificate.method == CONN_EXACT) {this->prepare_flow_networks(*scratch, threads, certificate.inactive);}
+        const int *level_graph = certificate.level_graph ? certificate.level_graph->levels() : nullptr;
+        std::atomic<int> failing(invalid.size());
+
+        run_parallel(invalid.size(), threads, [&](const int thread, const int begin, const int end) {
+            int known_failure;
+            for (int i=begin; i<end; i++) {
+                if (stop and (i > failing.load(std::memory_order_relaxed))) {break;}
+                const int &invalid_class = invalid[i];
+                certificate.paths[invalid_class] = this->poi_paths(
+                    *scratch, thread, certificate.method, classes.representative[invalid_class], limit,
+                    certificate.inactive, level_graph, &certificate.used[invalid_class]);
+                if (stop and (certificate.paths[invalid_class] < limit)) {
+                    known_failure = failing.load();
+                    while ((i < known_failure) and (not failing.compare_exchange_weak(known_failure, i))) {}
+                    break;
+                }
+            }
+        });
+        this->return_scratch(std::move(scratch));
+
+        // Note the classes that use each sensor of the new paths
+        for (const int &invalid_class : invalid) {
+            for (const int &a_sensor : certificate.used[invalid_class]) {
+                certificate.users[a_sensor].push_back(invalid_class);
+            }
+        }
+    }
+
+    // Lowest class below the limit. Classes left unevaluated only come after it
+    for (a_class=0; a_class < classes.size(); a_class++) {
+        if (certificate.paths[a_class] < limit) {return a_class;}
+    }
+    return -1;
+}
+
+
+/* #####################################################################################################################
+ * CERTIFIED CONNECTIVITY SERVICES
+ */
+
+/** CERTIFIED M-CONNECTIVITY
+ * Same results as fast_m_connectivity, with the votes of the used sensors of every POI up to the first failure.
+ * With exact paths, the votes are those of the certified paths, which are as many as a fresh search finds, but not
+ *   necessarily the same ones
+ */
+int KCMC_Instance::fast_m_connectivity(const int m, const SensorSet &inactive_sensors,
+                                       std::unordered_map<int, int> *all_used_sensors,
+                                       ConnectivityCertificate *certificate) {
+    CheckResult result = this->check_m_connectivity(m, inactive_sensors, all_used_sensors, certificate);
+    if (not result.ok()) {return ((1+result.failing_poi)*1000000)+result.found;}  // Encoded the two ints
+    return (int)(result.total_paths);
+}
+CheckResult KCMC_Instance::check_m_connectivity(const int m, const SensorSet &inactive_sensors,
+                                                std::unordered_map<int, int> *all_used_sensors,
+                                                ConnectivityCertificate *certificate) {
+    CheckResult result;
+
+    // Clear the set of active sensors
+    all_used_sensors->clear();
+
+    // Base case
+    if (m < 1){return result;}
+
+    // Update the certificate and aggregate the POIs in order, returning at the first failure
+    const PoiClasses &classes = this->poi_classes();
+    this->certify(*certificate, m, inactive_sensors, true);
+    int a_class;
+    for (int a_poi=0; a_poi < this->num_pois; a_poi++) {
+        a_class = classes.of_poi[a_poi];
+        for (const int &a_sensor : certificate->used[a_class]) {vote(*all_used_sensors, a_sensor);}
+        if (certificate->paths[a_class] < m) {
+            result.failing_poi = a_poi;
+            result.found = certificate->paths[a_class];
+            return result;
+        }
+        result.total_paths += certificate->paths[a_class];
+    }
+
+    // Success in each and every POI!
+    return result;
+}
+
+
+/** CERTIFIED VALIDATOR
+ * Same as validate, without the used sensors. Only the POIs invalidated by the changes are re-routed (see certify)
+ */
+bool KCMC_Instance::validate(const bool raise, const int k, const int m, const SensorSet &inactive_sensors,
+                             ConnectivityCertificate *certificate) {
+    if (not this->check_k_coverage(k, inactive_sensors).ok()) {
+        if (raise) {throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)");}
+        else {return false;}
+    }
+    if ((m >= 1) and (this->certify(*certificate, m, inactive_sensors, true) != -1)) {
+        if (raise) {throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT CONNECTIVITY)");}
+        else {return false;}
+    }
+    return true;
+}
+
+
+/** CERTIFIED CONNECTIVITY GETTER
+ * Same results as get_connectivity, with every class evaluated
+ */
+int KCMC_Instance::get_connectivity(int buffer[], const SensorSet &inactive_sensors, const int target,
+                                    ConnectivityCertificate *certificate) {
+    const PoiClasses &classes = this->poi_classes();
+    this->certify(*certificate, target, inactive_sensors, false);
+
+    // Return the number of POIs under the target
+    int has_connection = 0;
+    for (int a_poi=0; a_poi < this->num_pois; a_poi++) {
+        buffer[a_poi] = certificate->paths[classes.of_poi[a_poi]];
+        if (buffer[a_poi] < target) {has_connection += 1;}
+    }
+    return has_connection;
+}
@@ -0,0 +1,120 @@
+/** COVERAGE_MATRIX.cpp
+ * Implementation of the dense POI x sensor coverage bit-matrix, and of its popcount kernels
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::fill
+
+// SIMD intrinsics, only when the target has them (e.g. building with KCMC_NATIVE)
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* #####################################################################################################################
+ * POPCOUNT KERNELS
+ */
+
+/** ACTIVE POPCOUNT
+ * Number of bits set in row that are not set in inactive, over num_words words. This is the number of active sensors
+ * in a coverage row. The widest available kernel is chosen at compile time:
+ * - AVX-512 with VPOPCNTDQ: native 64-bit popcount of 8 words at a time, with a masked tail
+ * - AVX2: nibble lookup popcount (pshufb) of 4 words at a time, summed with psadbw
+ * - Otherwise, the portable word-by-word popcount
+ */
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+static int active_popcount(const uint64_t *row, const uint64_t *inactive, const int num_words) {
+    int i;
+    __m512i total = _mm512_setzero_si512();
+    for (i=0; i+8 <= num_words; i+=8) {
+        __m512i active = _mm512_andnot_si512(_mm512_loadu_si512(inactive + i), _mm512_loadu_si512(row + i));
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(active));
+    }
+    if (i < num_words) {
+        __mmask8 tail = (__mmask8)((1U << (num_words - i)) - 1);
+        __m512i active = _mm512_andnot_si512(_mm512_maskz_loadu_epi64(tail, inactive + i),
+                                             _mm512_maskz_loadu_epi64(tail, row + i));
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(active));
+    }
+    return (int)_mm512_reduce_add_epi64(total);
+}
+#elif defined(__AVX2__)
+static int active_popcount(const uint64_t *row, const uint64_t *inactive, const int num_words) {
+    int i, count;
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+    for (i=0; i+4 <= num_words; i+=4) {
+        __m256i active = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i *)(inactive + i)),
+                                             _mm256_loadu_si256((const __m256i *)(row + i)));
+        __m256i counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(lookup, _mm256_and_si256(active, low_nibbles)),
+            _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(active, 4), low_nibbles)));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+    count = (int)(_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1)
+                  + _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+    for (; i<num_words; i++) {count += __builtin_popcountll(row[i] & ~inactive[i]);}
+    return count;
+}
+#else
+static int active_popcount(const uint64_t *row, const uint64_t *inactive, const int num_words) {
+    int count = 0;
+    for (int i=0; i<num_words; i++) {count += __builtin_popcountll(row[i] & ~inactive[i]);}
+    return count;
+}
+#endif
+
+
+/* #####################################################################################################################
+ * COVERAGE MATRIX
+ */
+
+/** COVERAGE MATRIX BUILDER
+ * Sets, in the row of each POI, the bit of every sensor covering it
+ */
+void CoverageMatrix::build(const CSR_Adjacency &poi_sensor, const int num_sensors) {
+    this->rows = poi_sensor.num_sources();
+    this->columns = num_sensors;
+    this->words_per_row = (num_sensors + 63) / 64;
+    this->bits.assign((size_t)(this->rows) * this->words_per_row, 0);
+    for (int n_poi=0; n_poi < this->rows; n_poi++) {
+        uint64_t *row = this->bits.data() + (size_t)(n_poi) * this->words_per_row;
+        for (const int &a_sensor : poi_sensor[n_poi]) {row[a_sensor >> 6] |= (1ULL << (a_sensor & 63));}
+    }
+}
+
+void CoverageMatrix::clear() {
+    this->rows = 0;
+    this->columns = 0;
+    this->words_per_row = 0;
+    this->bits.clear();
+}
+
+
+/** COVERAGE OF A POI
+ * Number of active sensors covering the POI
+ */
+int CoverageMatrix::coverage(const int poi, const SensorSet &inactive_sensors) const {
+    return active_popcount(this->bits.data() + (size_t)(poi) * this->words_per_row,
+                           inactive_sensors.words.data(), this->words_per_row);
+}
+
+
+/** COVERAGE OF EVERY POI
+ * Stores the coverage of each POI in the buffer, and returns the number of POIs with any coverage at all
+ */
+int CoverageMatrix::coverage(int buffer[], const SensorSet &inactive_sensors) const {
+    int has_coverage = 0;
+    for (int n_poi=0; n_poi < this->rows; n_poi++) {
+        buffer[n_poi] = this->coverage(n_poi, inactive_sensors);
+        has_coverage += buffer[n_poi] > 0 ? 1 : 0;
+    }
+    return has_coverage;
+}
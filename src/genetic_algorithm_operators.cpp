@@ -100,8 +100,7 @@ int selection_roulette(int sel_size, std::vector<int> *selection, int pop_size,
     selection->clear();
 
     // Prepare an array to store already selected individual positions
-    double selected[pop_size];
-    std::fill(selected, selected+pop_size, 1.0);
+    std::vector<double> selected(pop_size, 1.0);
 
     // Compute the total fitness
     double total_fitness = std::accumulate(fitness, fitness+pop_size, 0.0);
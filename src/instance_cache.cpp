@@ -0,0 +1,135 @@
+/** INSTANCE_CACHE.cpp
+ * Implementation of the local on-disk cache of regenerated KCMC instances and their derived artifacts
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <cstdio>     // rename, remove, snprintf
+#include <cstdlib>    // getenv
+#include <cstring>    // memcmp, memset, strncpy
+#include <fstream>    // ifstream, ofstream
+#include <stdexcept>  // runtime_error
+
+// POSIX dependencies
+#include <unistd.h>    // getpid
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* #####################################################################################################################
+ * CACHE LOCATION
+ */
+
+#define KCMC_LEVELS_MAGIC "KCMCLVL"
+
+/* Header of the base level graph files in the cache. The levels (int32, host byte order) follow the header */
+struct KCMC_LevelsHeader {
+    char magic[8];
+    uint32_t version, byte_order;
+    int32_t num_sensors, max_level;
+};
+
+
+/** Cache directory. Empty disables the cache
+ */
+std::string KCMC_Instance::cache_directory = (getenv("KCMC_CACHE_DIR") != nullptr) ? getenv("KCMC_CACHE_DIR") : "";
+
+
+/** Cache file path
+ * Content-addressed by the FNV-1a 64-bit hash of the instance key
+ */
+std::string KCMC_Instance::cache_path(const std::string &extension) const {
+    char name[17];
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char &c : this->key()) {hash = (hash ^ (uint8_t)c) * 1099511628211ULL;}
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+    return cache_directory + "/" + name + extension;
+}
+
+
+/* #####################################################################################################################
+ * CACHE READ & WRITE
+ */
+
+/** Cache reader
+ * Maps the cached binary adjacencies of the instance key, and reads its cached base level graph.
+ * Any missing, invalid or colliding cache entry is a cache miss, and leaves the instance untouched
+ */
+bool KCMC_Instance::load_cached() {
+    if (cache_directory.empty()) {return false;}
+
+    std::string expected_key = this->key(), path = this->cache_path(".kcmcb");
+    if (not is_binary_instance(path)) {return false;}
+
+    // Map the cached adjacencies, restoring the key fields if they belong to another instance
+    int fields[6] = {this->num_pois, this->num_sensors, this->num_sinks,
+                     this->area_side, this->sensor_coverage_radius, this->sensor_communication_radius};
+    long long seed = this->random_seed;
+    try {
+        this->attach_binary(std::make_shared<MappedFile>(path));
+        if (this->key() != expected_key) {throw std::runtime_error("CACHE KEY COLLISION!");}
+    } catch (const std::exception &exc) {
+        this->num_pois = fields[0]; this->num_sensors = fields[1]; this->num_sinks = fields[2];
+        this->area_side = fields[3]; this->sensor_coverage_radius = fields[4]; this->sensor_communication_radius = fields[5];
+        this->random_seed = seed;
+        for (CSR_Adjacency *adjacency : {&this->poi_sensor, &this->sensor_poi, &this->sensor_sensor,
+                                         &this->sensor_sink, &this->sink_sensor}) {adjacency->clear();}
+        this->mapping.reset();
+        return false;
+    }
+
+    // Read the cached base level graph, or compute it if it is not there
+    KCMC_LevelsHeader header;
+    std::vector<int> levels(this->num_sensors);
+    std::ifstream file(this->cache_path(".levels"), std::ios::binary);
+    if (file.read((char *)(&header), sizeof(header))
+        and (memcmp(header.magic, KCMC_LEVELS_MAGIC, sizeof(header.magic)) == 0)
+        and (header.version == KCMC_BINARY_VERSION) and (header.byte_order == KCMC_BINARY_BYTE_ORDER)
+        and (header.num_sensors == this->num_sensors)
+        and file.read((char *)(levels.data()), sizeof(int) * levels.size())) {
+        this->base_levels.swap(levels);
+        this->base_max_level = header.max_level;
+    } else {
+        this->compute_base_levels();
+    }
+    return true;
+}
+
+
+/** Cache writer
+ * Stores the binary adjacencies and the base level graph of the instance. Each file is written to a temporary name
+ * and then renamed, so concurrent processes never map a partially-written file. Failures are silently ignored
+ */
+void KCMC_Instance::store_cached() {
+    if (cache_directory.empty()) {return;}
+
+    std::string suffix = ".tmp." + std::to_string(getpid());
+    std::string instance_path = this->cache_path(".kcmcb"), levels_path = this->cache_path(".levels");
+
+    // Store the adjacencies
+    try {
+        this->write_binary(instance_path + suffix);
+        if (rename((instance_path + suffix).c_str(), instance_path.c_str()) != 0) {remove((instance_path + suffix).c_str());}
+    } catch (const std::exception &exc) {
+        remove((instance_path + suffix).c_str());
+        return;
+    }
+
+    // Store the base level graph
+    KCMC_LevelsHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, KCMC_LEVELS_MAGIC, sizeof(header.magic));
+    header.version = KCMC_BINARY_VERSION;
+    header.byte_order = KCMC_BINARY_BYTE_ORDER;
+    header.num_sensors = this->num_sensors;
+    header.max_level = this->base_max_level;
+    std::ofstream file(levels_path + suffix, std::ios::binary | std::ios::trunc);
+    file.write((const char *)(&header), sizeof(header));
+    file.write((const char *)(this->base_levels.data()), sizeof(int) * this->base_levels.size());
+    file.close();
+    if ((not file) or (rename((levels_path + suffix).c_str(), levels_path.c_str()) != 0)) {
+        remove((levels_path + suffix).c_str());
+    }
+}
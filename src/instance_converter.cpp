@@ -0,0 +1,58 @@
+/*
+ * KCMC Instance converter
+ * Converts instances between the serialized text format and the memory-mappable binary format
+ */
+
+
+// STDLib Dependencies
+#include <iostream>  // cin, cout, endl
+#include <fstream>   // ofstream
+
+// Dependencies from this package
+#include "kcmc_instance.h"
+
+
+/* #####################################################################################################################
+ * RUNTIME
+ * */
+
+
+void help() {
+    std::cout << "Please, use the correct input for the KCMC instance converter:" << std::endl << std::endl;
+    std::cout << "./instance_converter <input> [output]" << std::endl;
+    std::cout << "  where:" << std::endl << std::endl;
+    std::cout << "<input> is a serialized KCMC instance, a file containing one, - for STDIN, or a binary KCMC instance file" << std::endl;
+    std::cout << "[output] is the output file. Text instances are converted to binary, and binary instances to text" << std::endl;
+    std::cout << "If [output] is not given, the text instance is printed to STDOUT. Binary outputs require a file" << std::endl;
+    exit(0);
+}
+
+
+int main(int argc, char* const argv[]) {
+    if (argc < 2) { help(); }
+
+    // Buffers
+    bool to_binary;
+    std::string source = argv[1];
+    KCMC_Instance *instance;
+
+    // Get the input instance. Binary files are mapped, text instances are parsed
+    to_binary = not is_binary_instance(source);
+    instance = KCMC_Instance::load(source);
+
+    // Write the output instance
+    if (to_binary) {
+        if (argc < 3) { help(); }
+        instance->write_binary(argv[2]);
+    } else if (argc < 3) {
+        instance->serialize(std::cout);
+        std::cout << std::endl;
+    } else {
+        std::ofstream out(argv[2]);
+        instance->serialize(out);
+        out << std::endl;
+    }
+
+    delete instance;
+    return 0;
+}
@@ -22,8 +22,10 @@ void help() {
     std::cout << "  where:" << std::endl << std::endl;
     std::cout << "K > 0 is the evaluated K coverage. If K <=0, the instance will not be evaluated but regenerated from its key, and M is ignored." << std::endl;
     std::cout << "M >= K is the evaluated M connectivity. Ignored if K <= 0" << std::endl;
-    std::cout << "<instance> is the serialized KCMC instance" << std::endl;
+    std::cout << "<instance> is the serialized KCMC instance, the path of a text or binary KCMC instance file, or - for STDIN" << std::endl;
     std::cout << "<inactive+> is the set of 0+ inactive sensors, as integers. Ignored if K <= 0" << std::endl;
+    std::cout << "Set the environment variable KCMC_CONNECTIVITY=exact to validate M connectivity with exact max-flow instead of greedy paths" << std::endl;
+    std::cout << "Set the environment variable KCMC_THREADS to evaluate M connectivity with that many threads (0 for all cores)" << std::endl;
     exit(0);
 }
 
@@ -44,7 +46,7 @@ int main(int argc, char* const argv[]) {
     if (argc > 3) {for (int i=4; i<argc; i++){inactive_sensors.insert(atoi(argv[i]));}}
 
     // De-serialize the instance
-    auto *instance = new KCMC_Instance(serialized_instance);
+    auto *instance = KCMC_Instance::load(serialized_instance);
 
     // If K <= 0, just print the instance and return
     if (k <= 0) {
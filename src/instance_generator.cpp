@@ -22,8 +22,9 @@ void help(int argc, char* const argv[]) {
     for (int i=0; i<argc; i++) {std::cout << argv[i] << " ";}
     std::cout << std::endl;
     std::cout << "Please, use the correct input for the KCMC instance generator:" << std::endl << std::endl;
-    std::cout << "./instance_generator <p> <s> <k> <area_s> <cov_v> <com_r> <seed>+" << std::endl;
+    std::cout << "./instance_generator [-b <dir>] <p> <s> <k> <area_s> <cov_v> <com_r> <seed>+" << std::endl;
     std::cout << "  where:" << std::endl << std::endl;
+    std::cout << "-b <dir> optionally also writes each generated instance to <dir> in the binary format" << std::endl;
     std::cout << "p > 0 is the number of POIs to be randomly generated" << std::endl;
     std::cout << "s > 0 is the number of Sensors to be generated" << std::endl;
     std::cout << "k > 0 is the number of Sinks to be generated. If n=1, the sink will be placed at the center of the area" << std::endl;
@@ -39,6 +40,13 @@ void help(int argc, char* const argv[]) {
 
 
 int main(int argc, char* const argv[]) {
+    // Optional binary output directory, as the first two arguments
+    std::string binary_dir;
+    if ((argc > 2) and (std::string(argv[1]) == "-b")) {
+        binary_dir = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
     if (argc < 7) {help(argc, argv);}
 
     /* ======================== *
@@ -46,9 +54,12 @@ int main(int argc, char* const argv[]) {
      * ======================== */
 
     /* Prepare Buffers */
-    int i, num_pois, num_sensors, num_sinks, area_side, coverage_radius, communication_radius, success, k, m;
+    int i, num_pois, num_sensors, num_sinks, area_side, coverage_radius, communication_radius, k, m;
+    bool success;
     long long random_seed, previous_seed;
-    std::unordered_set<int> emptyset, ignoredset;
+    SensorSet emptyset;
+    std::unordered_map<int, int> ignoredset;
+    KCMC_Instance *instance = nullptr;  // Generated once, and then reseeded in place for each further seed
 
     /* Parse CMD SETTINGS */
     num_pois    = atoi(argv[1]);
@@ -57,6 +68,7 @@ int main(int argc, char* const argv[]) {
     area_side   = atoi(argv[4]);
     coverage_radius = atoi(argv[5]);
     communication_radius = atoi(argv[6]);
+    emptyset.resize(num_sensors);
 
     // Get a random previous seed
     srand(time(NULL) + getpid());  // Diferent seed in each run for each process
@@ -82,38 +94,43 @@ int main(int argc, char* const argv[]) {
 
             // Try many times until get a valid instance
             while (random_seed < (previous_seed + 10000)) {  // MANY ATTEMPTS!
-                success = 0;
-                auto *instance = new KCMC_Instance(num_pois, num_sensors, num_sinks,
-                                                   area_side, coverage_radius, communication_radius,
-                                                   random_seed);
-                success = instance->fast_k_coverage(k, emptyset);
-                if (success == -1) {
-                    success = instance->fast_m_connectivity(m, emptyset, &ignoredset);
-                    if (success == -1) {
+                success = false;
+                if (instance == nullptr) {
+                    instance = new KCMC_Instance(num_pois, num_sensors, num_sinks,
+                                                 area_side, coverage_radius, communication_radius, random_seed);
+                } else {instance->reseed(random_seed);}
+                if (instance->check_k_coverage(k, emptyset).ok()) {
+                    success = instance->check_m_connectivity(m, emptyset, &ignoredset).ok();
+                    if (success) {
                         //printf("%s | (K%dM%d)\n", instance->serialize().c_str(), k, m);
                         printf("KCMC;%s;END | (K%dM%d)\n", instance->key().c_str(), k, m);
+                        if (not binary_dir.empty()) {instance->write_binary(binary_dir + "/" + instance->file_key() + ".kcmcb");}
                         previous_seed = random_seed + std::abs((rand() % 100000)) + 7;
                         break;
                     }
                 }
                 random_seed++;
             }
-            if (success != -1) {printf("UNABLE TO GENERATE VALID INSTANCE WITH PARAMETERS %d %d %d %d %d %d 0 %d %d\n",
+            if (not success) {printf("UNABLE TO GENERATE VALID INSTANCE WITH PARAMETERS %d %d %d %d %d %d 0 %d %d\n",
                                        num_pois, num_sensors, num_sinks, area_side, coverage_radius, communication_radius, k, m);}
         } else {
             // FAIL-PRONE MODE
             try {
-                auto *instance = new KCMC_Instance(num_pois, num_sensors, num_sinks,
-                                                   area_side, coverage_radius, communication_radius,
-                                                   random_seed);
-                printf("%s\n", instance->serialize().c_str());
+                if (instance == nullptr) {
+                    instance = new KCMC_Instance(num_pois, num_sensors, num_sinks,
+                                                 area_side, coverage_radius, communication_radius, random_seed);
+                } else {instance->reseed(random_seed);}
+                std::string serialized_instance = instance->serialize();
+                printf("%s\n", serialized_instance.c_str());
+                if (not binary_dir.empty()) {instance->write_binary(binary_dir + "/" + instance->file_key() + ".kcmcb");}
 
                 /* FOR VERIFICATION */
                 if (argc == 8) {
-                    std::string serialized_instance = instance->serialize();
                     auto *new_instance = new KCMC_Instance(serialized_instance);
-                    if (new_instance->serialize() == instance->serialize()) {
-                        printf("%s\nEQUAL\n", new_instance->serialize().c_str());
+                    std::string new_serialized_instance = new_instance->serialize();
+                    delete new_instance;
+                    if (new_serialized_instance == serialized_instance) {
+                        printf("%s\nEQUAL\n", new_serialized_instance.c_str());
                     } else { throw std::runtime_error("NOT EQUAL!"); }
                 }
 
@@ -124,5 +141,6 @@ int main(int argc, char* const argv[]) {
         }
     }
 
+    delete instance;
     return (0);
 }
@@ -7,7 +7,11 @@
 // STDLib dependencies
 #include <sstream>    // ostringstream
 #include <random>     // mt19937, uniform_real_distribution
-#include <algorithm>  // std::find
+#include <algorithm>  // std::find, std::binary_search, std::min
+#include <cstdlib>    // getenv, atoi
+#include <exception>  // exception_ptr
+#include <stdexcept>  // runtime_error
+#include <thread>     // thread, hardware_concurrency
 
 // Dependencies from this package
 #include "kcmc_instance.h"  // KCMC Instance class headers
@@ -21,6 +25,9 @@
 /* ISIN (IS IN)
  * A method to determine if a given value is in a given set of values, overloaded for maximum re-usability
  */
+bool isin(const CSR_Adjacency &ref, const int item){return ref.degree(item) > 0;}
+bool isin(const SensorSet &ref, const int item){return ref.contains(item);}
+bool isin(const Neighbors &ref, const int item){return std::binary_search(ref.begin(), ref.end(), item);}
 bool isin(std::unordered_map<int, std::unordered_set<int>> &ref, const int item){return ref.find(item) != ref.end();}
 bool isin(std::unordered_map<int, int> &ref, const int item){return ref.find(item) != ref.end();}
 bool isin(std::unordered_set<int> &ref, const int item){return ref.find(item) != ref.end();}
@@ -83,12 +90,77 @@ void setify(std::unordered_set<int> &target, int size, int source[], int referen
 }
 
 
+void setify(SensorSet &target, int size, int source[], int reference) {
+    target.resize(size);
+    for (int i=0; i<size; i++) {if (source[i] == reference) {target.insert(i);}}
+}
+
+
 void setify(std::unordered_set<int> &target, std::unordered_map<int, int> *reference) {
     target.clear();
     for (const auto &i : *reference) {target.insert(i.first);}
 }
 
 
+/* RUN PARALLEL
+ * Contiguous blocks of [0, size), one for each thread. The first block runs in the calling thread
+ */
+void run_parallel(const int size, const int num_threads, const std::function<void(int, int, int)> &task) {
+    int threads = std::max(1, std::min(num_threads, size)), thread;
+    if (threads == 1) {task(0, 0, size); return;}
+
+    std::vector<std::thread> workers;
+    std::vector<std::exception_ptr> errors(threads);
+    auto run_block = [&](const int block) {
+        try {task(block, (int)((long long)size * block / threads), (int)((long long)size * (block + 1) / threads));}
+        catch (...) {errors[block] = std::current_exception();}
+    };
+    for (thread=1; thread<threads; thread++) {workers.emplace_back(run_block, thread);}
+    run_block(0);
+    for (std::thread &worker : workers) {worker.join();}
+    for (const std::exception_ptr &error : errors) {if (error) {std::rethrow_exception(error);}}
+}
+
+
+/* THREAD COUNT
+ * From the environment variable KCMC_THREADS: 1 if not set, and every hardware thread if 0
+ */
+static int default_num_threads() {
+    if (getenv("KCMC_THREADS") == nullptr) {return 1;}
+    int threads = atoi(getenv("KCMC_THREADS"));
+    if (threads <= 0) {threads = (int)std::thread::hardware_concurrency();}
+    return std::max(1, threads);
+}
+int KCMC_Instance::num_threads = default_num_threads();
+
+
+/* SENSOR SET
+ * Conversions from and to unordered sets, and population count
+ */
+SensorSet::SensorSet(const int width, const std::unordered_set<int> &source) : SensorSet(width) {
+    for (const int &item : source) {
+        if ((item >= 0) and (item < width)) {this->insert(item);}  // Sensors out of the instance are ignored
+    }
+}
+
+int SensorSet::count() const {
+    int total = 0;
+    for (const uint64_t &word : this->words) {total += __builtin_popcountll(word);}
+    return total;
+}
+
+void SensorSet::to_set(std::unordered_set<int> &target) const {
+    target.clear();
+    for (int i=0; i<this->width; i++) {if (this->contains(i)) {target.insert(i);}}
+}
+
+void SensorSet::require_width(const int expected) const {
+    if ((this->width != expected) or (this->words.size() != (size_t)((expected + 63) / 64))) {
+        throw std::runtime_error("SENSOR SET DOES NOT MATCH THE NUMBER OF SENSORS!");
+    }
+}
+
+
 /* #####################################################################################################################
  * KCMC-PROBLEM K-COVERAGE METHODS
  */
@@ -98,52 +170,212 @@ void setify(std::unordered_set<int> &target, std::unordered_map<int, int> *refer
  * Very trivial k-coverage validator
  */
 int KCMC_Instance::fast_k_coverage(const int k, std::unordered_set<int> &inactive_sensors) {
+    return this->fast_k_coverage(k, SensorSet(this->num_sensors, inactive_sensors));
+}
+int KCMC_Instance::fast_k_coverage(const int k, const SensorSet &inactive_sensors) {
+    CheckResult result = this->check_k_coverage(k, inactive_sensors);
+    return result.ok() ? -1 : (result.failing_poi*1000000)+result.found;  // Encoded the two ints
+}
+CheckResult KCMC_Instance::check_k_coverage(const int k, const SensorSet &inactive_sensors) {
+    CheckResult result;
+    inactive_sensors.require_width(this->num_sensors);
+
     // Base case
-    if (k < 1){return -1;}
+    if (k < 1){return result;}
 
     // Start buffers
-    unsigned long active_coverage;
-
-    // For each POI, count its coverage, returning and error if insufficient
-    for (int n_poi=0; n_poi < this->num_pois; n_poi++) {
-        active_coverage = set_diff(this->poi_sensor[n_poi], inactive_sensors).size();
+    const PoiClasses &classes = this->poi_classes();
+    bool use_matrix = this->coverage_matrix.fits(inactive_sensors);
+    int active_coverage;
+
+    // For each POI class, count the coverage of its representative, returning and error if insufficient
+    for (const int &n_poi : classes.representative) {
+        if (use_matrix and this->coverage_matrix.pays_off(this->poi_sensor[n_poi].size())) {
+            active_coverage = this->coverage_matrix.coverage(n_poi, inactive_sensors);
+        }
+        else {
+            active_coverage = 0;
+            for (const int &a_sensor : this->poi_sensor[n_poi]) {
+                if (not inactive_sensors.contains(a_sensor)) {active_coverage++;}
+            }
+        }
         if (active_coverage < k) {
-            return (n_poi*1000000)+(int)(active_coverage);
+            result.failing_poi = n_poi;
+            result.found = active_coverage;
+            return result;
         }
     }
 
     // Success in each and every POI!
-    return -1;
+    return result;
 }
 
 
 /** K-Coverage Validator that also returns the used sensors in k coverage
- * Very trivial k-coverage validator
+ * Single pass over the poi-sensor edges, collecting the used sensors in a bitset. If a deficits buffer is given, every
+ * POI is checked and its deficit (how many active sensors it lacks to be k-covered, or 0) is stored in the buffer.
+ * Otherwise, it stops at the first POI with insufficient coverage. Either way, the first failure is returned.
  */
 int KCMC_Instance::fast_k_coverage(const int k, std::unordered_set<int> &inactive_sensors, std::unordered_set<int> *result_buffer) {
-    // Clear the set of active sensors
-    result_buffer->clear();
+    return this->fast_k_coverage(k, SensorSet(this->num_sensors, inactive_sensors), result_buffer);
+}
+int KCMC_Instance::fast_k_coverage(const int k, const SensorSet &inactive_sensors, std::unordered_set<int> *result_buffer) {
+    SensorSet used_sensors;
+    int failure_at = this->fast_k_coverage(k, inactive_sensors, &used_sensors, nullptr);
+    used_sensors.to_set(*result_buffer);
+    return failure_at;
+}
+int KCMC_Instance::fast_k_coverage(const int k, const SensorSet &inactive_sensors,
+                                   SensorSet *used_sensors, std::vector<int> *deficits) {
+    CheckResult result = this->check_k_coverage(k, inactive_sensors, used_sensors, deficits);
+    return result.ok() ? -1 : (result.failing_poi*1000000)+result.found;  // Encoded the two ints
+}
+CheckResult KCMC_Instance::check_k_coverage(const int k, const SensorSet &inactive_sensors,
+                                            SensorSet *used_sensors, std::vector<int> *deficits) {
+    CheckResult result;
+    inactive_sensors.require_width(this->num_sensors);
+
+    // Clear the set of active sensors and the deficits
+    used_sensors->resize(this->num_sensors);
+    if (deficits != nullptr) {deficits->assign(this->num_pois, 0);}
 
     // Base case
-    if (k < 1){return -1;}
+    if (k < 1){return result;}
 
     // Start buffers
-    std::unordered_set<int> buffer_set, all_used_sensors;
-    unsigned long active_coverage;
-
-    // For each POI, count its coverage, returning and error if insufficient. Also note all used sensors
-    for (int n_poi=0; n_poi < this->num_pois; n_poi++) {
-        buffer_set = set_diff(this->poi_sensor[n_poi], inactive_sensors);
-        active_coverage = buffer_set.size();
-        all_used_sensors = set_merge(all_used_sensors, buffer_set);
-        *result_buffer = all_used_sensors;
+    const PoiClasses &classes = this->poi_classes();
+    int active_coverage, n_poi;
+
+    // For each POI class, count the coverage of its representative, returning and error if insufficient. Also note
+    // all used sensors
+    for (const int &representative : classes.representative) {
+        n_poi = representative;
+        active_coverage = 0;
+        for (const int &a_sensor : this->poi_sensor[n_poi]) {
+            if (not inactive_sensors.contains(a_sensor)) {
+                used_sensors->insert(a_sensor);
+                active_coverage++;
+            }
+        }
         if (active_coverage < k) {
-            return (n_poi*1000000)+(int)(active_coverage);
+            if (result.ok()) {result.failing_poi = n_poi; result.found = active_coverage;}
+            if (deficits == nullptr) {return result;}
+            (*deficits)[n_poi] = k - active_coverage;
         }
     }
 
-    // Success in each and every POI!
-    return -1;
+    // Expand the deficits of the representatives to their classes
+    if (deficits != nullptr) {
+        for (n_poi=0; n_poi < this->num_pois; n_poi++) {
+            (*deficits)[n_poi] = (*deficits)[classes.representative[classes.of_poi[n_poi]]];
+        }
+    }
+
+    // Success in each and every POI, if no failure was found
+    return result;
+}
+
+
+/* #####################################################################################################################
+ * INCREMENTAL K-COVERAGE STATE
+ */
+
+
+/** Coverage state constructor
+ * Starts with every sensor of the instance active
+ */
+CoverageState::CoverageState(const KCMC_Instance *instance, const int k)
+    : instance(instance), k(k), below_k(0), covered(0), counts(instance->num_pois, 0) {
+    this->reset(SensorSet(instance->num_sensors));
+}
+
+
+/** Coverage state reset
+ * Recomputes the coverage of every POI from scratch, in O(poi-sensor edges)
+ */
+void CoverageState::reset(const SensorSet &inactive_sensors) {
+    int n_poi;
+
+    // Copy the inactive sensors
+    inactive_sensors.require_width(this->instance->num_sensors);
+    this->inactive = inactive_sensors;
+
+    // Count the active coverage of each POI, in the coverage matrix if the instance has one and the POI is dense
+    const CoverageMatrix &matrix = this->instance->coverage_matrix;
+    bool use_matrix = matrix.fits(this->inactive);
+    this->below_k = 0;
+    this->covered = 0;
+    for (n_poi=0; n_poi < this->instance->num_pois; n_poi++) {
+        if (use_matrix and matrix.pays_off(this->instance->poi_sensor[n_poi].size())) {
+            this->counts[n_poi] = matrix.coverage(n_poi, this->inactive);
+        } else {
+            this->counts[n_poi] = 0;
+            for (const int &a_sensor : this->instance->poi_sensor[n_poi]) {
+                if (not this->inactive.contains(a_sensor)) {this->counts[n_poi]++;}
+            }
+        }
+        if (this->counts[n_poi] < this->k) {this->below_k++;}
+        if (this->counts[n_poi] > 0) {this->covered++;}
+    }
+}
+
+
+/** Coverage state sync
+ * Toggles each sensor whose state differs from the given set of inactive sensors, comparing 64 sensors at a time.
+ * If the instance has a coverage matrix and toggling would touch more poi-sensor edges than the matrix has words,
+ *   the coverage is recounted from the matrix instead
+ */
+void CoverageState::sync(const SensorSet &inactive_sensors) {
+    int word_index, bit, num_words = (int)this->inactive.words.size();
+    long long differences = 0;
+    uint64_t difference;
+
+    inactive_sensors.require_width(this->instance->num_sensors);
+    if (this->instance->coverage_matrix.fits(inactive_sensors)) {
+        for (word_index=0; word_index < num_words; word_index++) {
+            differences += __builtin_popcountll(this->inactive.words[word_index] ^ inactive_sensors.words[word_index]);
+        }
+        if (differences * this->instance->sensor_poi.num_edges()
+            > (long long)(this->instance->coverage_matrix.num_words()) * this->instance->num_sensors) {
+            this->reset(inactive_sensors);
+            return;
+        }
+    }
+
+    for (word_index=0; word_index < num_words; word_index++) {
+        difference = this->inactive.words[word_index] ^ inactive_sensors.words[word_index];
+        while (difference != 0) {
+            bit = (word_index * 64) + __builtin_ctzll(difference);
+            difference &= difference - 1;
+            if (bit >= this->instance->num_sensors) {break;}  // Stray bits past the last sensor are ignored
+            if (this->inactive.contains(bit)) {this->activate(bit);}
+            else {this->deactivate(bit);}
+        }
+    }
+}
+
+
+/** Coverage state toggles
+ * Activating or deactivating a sensor updates only the POIs it covers. Repeated toggles are ignored
+ */
+void CoverageState::activate(const int sensor) {
+    if (not this->inactive.contains(sensor)) {return;}
+    this->inactive.erase(sensor);
+    for (const int &a_poi : this->instance->sensor_poi[sensor]) {
+        this->counts[a_poi]++;
+        if (this->counts[a_poi] == this->k) {this->below_k--;}
+        if (this->counts[a_poi] == 1) {this->covered++;}
+    }
+}
+
+void CoverageState::deactivate(const int sensor) {
+    if (this->inactive.contains(sensor)) {return;}
+    this->inactive.insert(sensor);
+    for (const int &a_poi : this->instance->sensor_poi[sensor]) {
+        this->counts[a_poi]--;
+        if (this->counts[a_poi] == this->k - 1) {this->below_k++;}
+        if (this->counts[a_poi] == 0) {this->covered--;}
+    }
 }
 
 
@@ -151,12 +383,11 @@ int KCMC_Instance::fast_k_coverage(const int k, std::unordered_set<int> &inactiv
  * Wrapper around the fastest validator, to allow for better process message passing.
  */
 std::string KCMC_Instance::k_coverage(const int k, std::unordered_set<int> &inactive_sensors) {
-    int failure_at = this->fast_k_coverage(k, inactive_sensors);
-    if (failure_at == -1) {return "SUCCESS";}
+    CheckResult result = this->check_k_coverage(k, SensorSet(this->num_sensors, inactive_sensors));
+    if (result.ok()) {return "SUCCESS";}
     else {
         std::ostringstream out;
-        int n_poi = failure_at / 1000000, active_coverage = failure_at % 1000000;  // Decode the result
-        out << "POI " << n_poi << " COVERAGE " << active_coverage;
+        out << "POI " << result.failing_poi << " COVERAGE " << result.found;
         return out.str();
     }
 }
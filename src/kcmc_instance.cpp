@@ -7,12 +7,135 @@
 // STDLib dependencies
 #include <sstream>    // ostringstream
 #include <random>     // mt19937, uniform_real_distribution
-#include <algorithm>  // std::find
+#include <algorithm>  // std::find, std::sort, std::unique, std::binary_search
+#include <climits>    // INT_MIN, INT_MAX, LLONG_MAX
 
 // Dependencies from this package
 #include "kcmc_instance.h"  // KCMC Instance class headers
 
 
+/* #####################################################################################################################
+ * GRAPH STORAGE
+ */
+
+/** CSR ADJACENCY BUILDER
+ * Compacts a list of (source, target) edges into sorted contiguous rows, one for each source in [0, num_sources).
+ * If transpose is set, the edges are read as (target, source). Repeated edges are stored only once.
+ */
+void CSR_Adjacency::build(const int num_sources, std::vector<std::pair<int, int>> &edges, const bool transpose) {
+    int i, source, write_pos;
+    std::vector<int> &offsets = this->offset_storage, &neighbors = this->neighbor_storage;
+
+    // Count the degree of each source, shifted by one position to become the offsets after the prefix sum
+    offsets.assign(num_sources+1, 0);
+    for (const auto &edge : edges) {
+        source = transpose ? edge.second : edge.first;
+        if ((source < 0) or (source >= num_sources)) {throw std::runtime_error("EDGE SOURCE OUT OF RANGE!");}
+        offsets[source+1]++;
+    }
+    for (i=0; i<num_sources; i++) {offsets[i+1] += offsets[i];}
+
+    // Scatter the targets in their rows, moving each row start offset up to its end offset, then shift them back
+    neighbors.resize(edges.size());
+    for (const auto &edge : edges) {
+        if (transpose) {neighbors[offsets[edge.second]++] = edge.first;}
+        else           {neighbors[offsets[edge.first]++] = edge.second;}
+    }
+    for (i=num_sources; i>0; i--) {offsets[i] = offsets[i-1];}
+    offsets[0] = 0;
+
+    // Sort each row and squeeze out the repeated edges, shifting the rows to the left
+    write_pos = 0;
+    for (i=0; i<num_sources; i++) {
+        auto row_begin = neighbors.begin() + offsets[i], row_end = neighbors.begin() + offsets[i+1];
+        std::sort(row_begin, row_end);
+        row_end = std::unique(row_begin, row_end);
+        offsets[i] = write_pos;
+        write_pos = (int)(std::copy(row_begin, row_end, neighbors.begin() + write_pos) - neighbors.begin());
+    }
+    offsets[num_sources] = write_pos;
+    neighbors.resize(write_pos);
+
+    // Read from the owned storage
+    this->rows = num_sources;
+    this->offset_view = offsets.data();
+    this->neighbor_view = neighbors.data();
+}
+
+
+/** CSR ADJACENCY STREAMING BUILDER
+ * Builds the adjacency row by row, in source order: append_row(source, neighbors) appends the targets of the source to
+ * the storage, which are then sorted and squeezed. No edge list is ever kept, only the adjacency itself
+ */
+void CSR_Adjacency::build(const int num_sources, const std::function<void(int, std::vector<int> &)> &append_row) {
+    int i;
+    std::vector<int> &offsets = this->offset_storage, &neighbors = this->neighbor_storage;
+
+    offsets.assign(num_sources+1, 0);
+    neighbors.clear();
+    for (i=0; i<num_sources; i++) {
+        append_row(i, neighbors);
+        auto row_begin = neighbors.begin() + offsets[i];
+        std::sort(row_begin, neighbors.end());
+        neighbors.erase(std::unique(row_begin, neighbors.end()), neighbors.end());
+        offsets[i+1] = (int)neighbors.size();
+    }
+
+    // Read from the owned storage
+    this->rows = num_sources;
+    this->offset_view = offsets.data();
+    this->neighbor_view = neighbors.data();
+}
+
+
+/** CSR ADJACENCY ATTACHMENT
+ * Reads the adjacency from arrays owned by someone else, that must outlive it. Nothing is copied
+ */
+void CSR_Adjacency::attach(const int num_sources, const int *offsets, const int *neighbors) {
+    this->offset_storage.clear();
+    this->neighbor_storage.clear();
+    this->rows = num_sources;
+    this->offset_view = offsets;
+    this->neighbor_view = neighbors;
+}
+
+
+/** CSR ADJACENCY COPY
+ * Copies of an adjacency that owns its storage read from their own copy of the storage. Attached copies share views
+ */
+CSR_Adjacency::CSR_Adjacency(const CSR_Adjacency &other) : CSR_Adjacency() {*this = other;}
+CSR_Adjacency &CSR_Adjacency::operator=(const CSR_Adjacency &other) {
+    if (this == &other) {return *this;}
+    this->rows = other.rows;
+    if (other.owns_storage()) {
+        this->offset_storage = other.offset_storage;
+        this->neighbor_storage = other.neighbor_storage;
+        this->offset_view = this->offset_storage.data();
+        this->neighbor_view = this->neighbor_storage.data();
+    } else {
+        this->offset_storage.clear();
+        this->neighbor_storage.clear();
+        this->offset_view = other.offset_view;
+        this->neighbor_view = other.neighbor_view;
+    }
+    return *this;
+}
+
+
+/** CSR ADJACENCY UTILITIES
+ */
+void CSR_Adjacency::clear() {
+    this->offset_storage.clear();
+    this->neighbor_storage.clear();
+    this->rows = 0;
+    this->offset_view = this->neighbor_view = nullptr;
+}
+bool CSR_Adjacency::has(const int source, const int target) const {
+    return std::binary_search(this->neighbor_view + this->offset_view[source],
+                              this->neighbor_view + this->offset_view[source+1], target);
+}
+
+
 /* #####################################################################################################################
  * INSTANCE OPERATION & CONSTRUCTORS
  */
@@ -62,6 +185,69 @@ void KCMC_Instance::get_placements(Placement *pl_pois, Placement *pl_sensors, Pl
 }
 
 
+/** UNIFORM GRID SPATIAL INDEX BUILDER
+ * Counting-sorts the placement indexes by cell. The offsets are used as scatter cursors and shifted back afterwards,
+ * so rebuilding a grid reuses its storage without any allocation.
+ * The cells are at least as large as the radius, and grow so that there are about as many cells as placements, as a
+ * small radius over a large area would otherwise need far more (empty) cells than placements
+ */
+void UniformGrid::build(const Placement *placements, const int size, const int radius, const int area_side) {
+    int i;
+    size_t cell, num_cells;
+    int per_row = std::max(1, (int)std::ceil(std::sqrt((double)size)));
+    this->cell_side = std::max(std::max(radius, 1), area_side / per_row);
+    this->cells_per_row = (area_side / this->cell_side) + 1;
+    num_cells = (size_t)(this->cells_per_row) * this->cells_per_row;
+
+    // Count the placements in each cell, shifted by one position to become the offsets after the prefix sum
+    this->cell_offsets.assign(num_cells + 1, 0);
+    for (i=0; i<size; i++) {
+        cell = (size_t)(this->cell_of(placements[i].y)) * this->cells_per_row + this->cell_of(placements[i].x);
+        this->cell_offsets[cell+1]++;
+    }
+    for (cell=1; cell<=num_cells; cell++) {this->cell_offsets[cell] += this->cell_offsets[cell-1];}
+
+    // Scatter the indexes, moving each cell start offset up to its end offset, and then shift the offsets back
+    this->cell_items.resize(size);
+    for (i=0; i<size; i++) {
+        cell = (size_t)(this->cell_of(placements[i].y)) * this->cells_per_row + this->cell_of(placements[i].x);
+        this->cell_items[this->cell_offsets[cell]++] = i;
+    }
+    for (cell=num_cells; cell>0; cell--) {this->cell_offsets[cell] = this->cell_offsets[cell-1];}
+    this->cell_offsets[0] = 0;
+}
+
+
+/* WITHIN RADIUS
+ * Integer equivalent of distance(source, target) <= radius, without square roots
+ */
+bool within_radius(const Placement &source, const Placement &target, const int radius) {
+    if (radius < 0) {return false;}
+    long long dx = source.x - target.x, dy = source.y - target.y;
+    return (dx*dx + dy*dy) <= ((long long)radius * radius);
+}
+
+
+/* APPEND NEAR ITEMS
+ * Appends to row the index of every item of the grid (other than exclude) within radius of the center, looking only at
+ * the 3x3 block of cells around the center. The cells of the grid must be as large as the radius
+ */
+static void append_near(const UniformGrid &grid, const Placement *items, const Placement &center, const int radius,
+                        const int exclude, std::vector<int> &row) {
+    int item, pos, row_index, col, cx = grid.cell_of(center.x), cy = grid.cell_of(center.y);
+    size_t cell;
+    for (row_index = std::max(cy-1, 0); row_index <= std::min(cy+1, grid.cells_per_row-1); row_index++) {
+        for (col = std::max(cx-1, 0); col <= std::min(cx+1, grid.cells_per_row-1); col++) {
+            cell = (size_t)(row_index) * grid.cells_per_row + col;
+            for (pos = grid.cell_offsets[cell]; pos < grid.cell_offsets[cell + 1]; pos++) {
+                item = grid.cell_items[pos];
+                if ((item != exclude) and within_radius(items[item], center, radius)) {row.push_back(item);}
+            }
+        }
+    }
+}
+
+
 /** RANDOM-INSTANCE (RE)GENERATOR
  * Generates the instance's placements and edges, assuming the instance already have all main attributes
  */
@@ -70,43 +256,135 @@ void KCMC_Instance::regenerate() {
      * This constructor is used only to generate a new random instance that already has the seed attributes
      */
 
-    // Prepare iteration buffers
-    int i, j;
-
-    // Prepare the placement buffers. The scope of these buffers is only the constructor itself
-    Placement pl_pois[this->num_pois], pl_sensors[this->num_sensors], pl_sinks[this->num_sinks];
+    // Prepare the placement buffers. They are kept in the instance, so regenerating it reuses them
+    this->pl_pois.resize(this->num_pois);
+    this->pl_sensors.resize(this->num_sensors);
+    this->pl_sinks.resize(this->num_sinks);
+    Placement *pl_pois = this->pl_pois.data(), *pl_sensors = this->pl_sensors.data(), *pl_sinks = this->pl_sinks.data();
+    const int coverage_radius = this->sensor_coverage_radius, communication_radius = this->sensor_communication_radius;
 
     // Get the placemens of the instance objects
+    this->poi.clear();
+    this->sensor.clear();
+    this->sink.clear();
     this->get_placements(pl_pois, pl_sensors, pl_sinks, true);  // Use the private version, that pushes components
 
-    // Iterate each sensor and find its connections
-    for (i=0; i<this->num_sensors; i++) {
+    /* Index the nodes in uniform grids, with cells at least as large as the coverage radius (sensors and POIs) or as the
+     * communication radius (sensors and sinks). Each node is then compared only to the nodes in the 3x3 block of
+     * cells around it, instead of to every node in the instance
+     */
+    this->coverage_grid.build(pl_sensors, this->num_sensors, coverage_radius, this->area_side);
+    this->communication_grid.build(pl_sensors, this->num_sensors, communication_radius, this->area_side);
+    this->poi_grid.build(pl_pois, this->num_pois, coverage_radius, this->area_side);
+    this->sink_grid.build(pl_sinks, this->num_sinks, communication_radius, this->area_side);
 
-        // Iterate each POI, identifying sensor-poi coverage
-        for (j=0; j < this->num_pois; j++) {
-            if (distance(pl_sensors[i], pl_pois[j]) <= this->sensor_coverage_radius) {
-                push(this->poi_sensor, j, i);
-                push(this->sensor_poi, i, j);
-            }
-        }
+    /* Stream each adjacency row by row, from the grid of its targets. Both directions of each relation are searched
+     * separately, so the graph is built with no edge list, in as much memory as the adjacencies themselves
+     */
+    this->poi_sensor.build(this->num_pois, [&](const int j, std::vector<int> &row) {
+        append_near(this->coverage_grid, pl_sensors, pl_pois[j], coverage_radius, -1, row);
+    });
+    this->sensor_poi.build(this->num_sensors, [&](const int i, std::vector<int> &row) {
+        append_near(this->poi_grid, pl_pois, pl_sensors[i], coverage_radius, -1, row);
+    });
+    this->sensor_sensor.build(this->num_sensors, [&](const int i, std::vector<int> &row) {
+        append_near(this->communication_grid, pl_sensors, pl_sensors[i], communication_radius, i, row);
+    });
+    this->sensor_sink.build(this->num_sensors, [&](const int i, std::vector<int> &row) {
+        append_near(this->sink_grid, pl_sinks, pl_sensors[i], communication_radius, -1, row);
+    });
+    this->sink_sensor.build(this->num_sinks, [&](const int j, std::vector<int> &row) {
+        append_near(this->communication_grid, pl_sensors, pl_sinks[j], communication_radius, -1, row);
+    });
+    // From here on, the placement buffers are no longer needed
 
-        // Verify if the sensor can connect to a SINK
-        for (j=0; j<this->num_sinks; j++) {
-            if (distance(pl_sensors[i], pl_sinks[j]) <= this->sensor_communication_radius) {
-                push(this->sensor_sink, i, j);  // Symetric communication between sink and sensors
-                push(this->sink_sensor, j, i);  // Symetric communication between sink and sensors
-            }
-        }
+    // Compute the derived artifacts of the graph
+    this->drop_derived();
+    this->compute_base_levels();
+}
+
+
+/** IN-PLACE RESEEDING
+ * Regenerates the instance for another random seed, keeping all other attributes.
+ * The node vectors, placement buffers, spatial grids and adjacency storage are all reused
+ */
+void KCMC_Instance::reseed(const long long random_seed) {
+    this->random_seed = random_seed;
+    this->regenerate();
+    this->mapping.reset();  // The adjacencies now own their storage, so a mapped file is no longer needed
+}
+
+
+/** GRAPH BUILDER
+ * Compacts the edge list buffers into the CSR adjacencies of the instance, in both directions of each edge
+ */
+void KCMC_Instance::build_graph() {
+    this->poi_sensor.build(this->num_pois, this->ps_edges, false);
+    this->sensor_poi.build(this->num_sensors, this->ps_edges, true);
+    this->sensor_sensor.build(this->num_sensors, this->ss_edges, false);
+    this->sensor_sink.build(this->num_sensors, this->sk_edges, false);
+    this->sink_sensor.build(this->num_sinks, this->sk_edges, true);
+
+    // The edge lists are no longer needed, but their storage is kept for the next (re)generation
+    this->ps_edges.clear();
+    this->ss_edges.clear();
+    this->sk_edges.clear();
+
+    // Compute the derived artifacts of the graph
+    this->drop_derived();
+    this->compute_base_levels();
+}
 
-        // Iterate each further sensor, identifying connections between sensors
-        for (j=i+1; j < this->num_sensors; j++) {
-            if (distance(pl_sensors[i], pl_sensors[j]) <= this->sensor_communication_radius) {
-                push(this->sensor_sensor, i, j);  // Symetric communication between sensors
-                push(this->sensor_sensor, j, i);  // Symetric communication between sensors
+
+/** DERIVED ARTIFACTS
+ * Drops the artifacts of the previous graph that are only built on request
+ */
+void KCMC_Instance::drop_derived() {
+    this->coverage_matrix.clear();
+    std::lock_guard<std::mutex> guard(this->scratch_lock);
+    this->scratch_pool.clear();  // Their flow networks were built for the previous graph
+    this->poi_class_storage = PoiClasses();
+}
+
+
+/** COVERAGE MATRIX BUILDER
+ * Builds the optional dense coverage matrix of the current graph
+ */
+void KCMC_Instance::build_coverage_matrix() {
+    this->coverage_matrix.build(this->poi_sensor, this->num_sensors);
+}
+
+
+/** POI CLASSES
+ * Groups the POIs by the hash of their (sorted) covering sensors, comparing the rows of equal hashes
+ */
+const PoiClasses &KCMC_Instance::poi_classes() {
+    PoiClasses &classes = this->poi_class_storage;
+    if ((int)classes.of_poi.size() == this->num_pois) {return classes;}
+
+    uint64_t hash;
+    std::unordered_map<uint64_t, std::vector<int>> classes_of_hash;
+    classes.of_poi.assign(this->num_pois, -1);
+    classes.representative.clear();
+    for (int a_poi=0; a_poi < this->num_pois; a_poi++) {
+        Neighbors row = this->poi_sensor[a_poi];
+        hash = 14695981039346656037ULL;
+        for (const int &a_sensor : row) {hash = (hash ^ (uint64_t)(a_sensor)) * 1099511628211ULL;}
+        std::vector<int> &candidates = classes_of_hash[hash];
+        for (const int &a_class : candidates) {
+            Neighbors other = this->poi_sensor[classes.representative[a_class]];
+            if ((other.size() == row.size()) and std::equal(row.begin(), row.end(), other.begin())) {
+                classes.of_poi[a_poi] = a_class;
+                break;
             }
         }
+        if (classes.of_poi[a_poi] == -1) {
+            classes.of_poi[a_poi] = classes.size();
+            candidates.push_back(classes.size());
+            classes.representative.push_back(a_poi);
+        }
     }
-    // From here on, the placement buffers are no longer needed
+    return classes;
 }
 
 
@@ -134,115 +412,145 @@ KCMC_Instance::KCMC_Instance(int num_pois, int num_sensors, int num_sinks,
 }
 
 
-/** INSTANCE DE-SERIALIZER CONSTRUCTOR
- * Constructor of a KCMC instance object from a serialized string
+/** INSTANCE DE-SERIALIZER CONSTRUCTORS
+ * Constructors of a KCMC instance object from a serialized string, or from the next line of a stream
  */
 KCMC_Instance::KCMC_Instance(const std::string& serialized_kcmc_instance) {
     /** Instance de-serializer constructor
      * This constructor is used to load a previously-generated instance. Node placements are irrelevant
      */
+    this->parse(serialized_kcmc_instance.data(), serialized_kcmc_instance.data() + serialized_kcmc_instance.size());
+}
+KCMC_Instance::KCMC_Instance(std::istream &serialized_kcmc_instance) {
+    /** Instance stream de-serializer constructor
+     * Reads a single serialized instance (a single line) from the stream, such as STDIN or a file
+     */
+    std::string line;
+    if (not std::getline(serialized_kcmc_instance, line)) {throw std::runtime_error("NO INSTANCE TO READ!");}
+    this->parse(line.data(), line.data() + line.size());
+}
+
+
+/** Utilities to the De-Serializer
+ * Integer parsing in the fashion of std::from_chars, skipping blanks, and a token comparator.
+ * Integers out of the range of the target type are rejected, as is an integer with no digits
+ */
+const char *parse_integer(const char *first, const char *last, long long &value) {
+    bool negative = false;
+    const char *digits;
+    unsigned long long magnitude, limit;
+
+    while ((first < last) and ((*first == ' ') or (*first == '\t'))) {first++;}
+    if ((first < last) and ((*first == '-') or (*first == '+'))) {negative = (*first == '-'); first++;}
+    limit = negative ? (unsigned long long)(LLONG_MAX) + 1 : (unsigned long long)(LLONG_MAX);
+    for (magnitude = 0, digits = first; (first < last) and (*first >= '0') and (*first <= '9'); first++) {
+        if (magnitude > (limit - (*first - '0')) / 10) {throw std::runtime_error("INVALID INTEGER IN INSTANCE!");}
+        magnitude = (magnitude * 10) + (*first - '0');
+    }
+    if (first == digits) {throw std::runtime_error("INVALID INTEGER IN INSTANCE!");}
+    value = negative ? (long long)(0ULL - magnitude) : (long long)(magnitude);
+    return first;
+}
+const char *parse_integer(const char *first, const char *last, int &value) {
+    long long buffer;
+    first = parse_integer(first, last, buffer);
+    if ((buffer < INT_MIN) or (buffer > INT_MAX)) {throw std::runtime_error("INVALID INTEGER IN INSTANCE!");}
+    value = (int)buffer;
+    return first;
+}
+bool token_is(const char *first, const char *last, const char *tag) {
+    while ((first < last) and (*tag != '\0') and (*first == *tag)) {first++; tag++;}
+    return (first == last) and (*tag == '\0');
+}
 
-    // Iterate the string, looking for tokens
-    size_t previous = 0, pos = 0;
-    std::string token;
-    int stage = 0, has_edges = 0;
-    while ((pos = serialized_kcmc_instance.find(';', previous)) != std::string::npos) {
-        token = serialized_kcmc_instance.substr(previous, pos-previous);
-        std::stringstream s_token(token);
 
-        switch(stage) {
+/** Single-pass De-Serializer
+ * Scans the serialized instance once, token by token, with no per-token allocation.
+ * The stages are: prefix, quantities, sizes, seed, and then the PS (poi-sensor), SS (sensor-sensor) and SK
+ * (sensor-sink) edge lists, until the END tag. An instance that has no edge lists at all is regenerated from its key
+ */
+void KCMC_Instance::parse(const char *first, const char *last) {
+    const char *token_end, *cursor;
+    int stage = 0, source, target;
+    bool has_edges = false;
+
+    this->num_pois = this->num_sensors = this->num_sinks = 0;
+    this->ps_edges.clear();
+    this->ss_edges.clear();
+    this->sk_edges.clear();
+
+    while ((first < last) and (stage != 8)) {
+        // Delimit the current token, ignoring blanks around it
+        for (token_end = first; (token_end < last) and (*token_end != ';'); token_end++) {}
+        cursor = token_end;
+        while ((first < cursor) and ((*first == ' ') or (*first == '\t') or (*first == '\r') or (*first == '\n'))) {first++;}
+        while ((first < cursor) and ((cursor[-1] == ' ') or (cursor[-1] == '\t') or (cursor[-1] == '\r') or (cursor[-1] == '\n'))) {cursor--;}
+
+        switch (stage) {
             case 0:
                 // VALIDATE PREFIX
-                if ("KCMC" != token) {throw std::runtime_error("INSTANCE DOES NOT STARTS WITH PREFIX 'KCMC'");}
+                if (not token_is(first, cursor, "KCMC")) {throw std::runtime_error("INSTANCE DOES NOT STARTS WITH PREFIX 'KCMC'");}
                 stage = 1;
                 break;
             case 1:
-                s_token >> this->num_pois;
-                s_token >> this->num_sensors;
-                s_token >> this->num_sinks;
+                first = parse_integer(first, cursor, this->num_pois);
+                first = parse_integer(first, cursor, this->num_sensors);
+                parse_integer(first, cursor, this->num_sinks);
                 stage = 2;
                 break;
             case 2:
-                s_token >> this->area_side;
-                s_token >> this->sensor_coverage_radius;
-                s_token >> this->sensor_communication_radius;
+                first = parse_integer(first, cursor, this->area_side);
+                first = parse_integer(first, cursor, this->sensor_coverage_radius);
+                parse_integer(first, cursor, this->sensor_communication_radius);
                 stage = 3;
                 break;
             case 3:
-                s_token >> this->random_seed;
+                parse_integer(first, cursor, this->random_seed);
                 stage = 4;
                 break;
-            case 4:
-                // FIRST-STAGE PARSER
-                has_edges = 1;
-                stage = this->parse_edge(stage, token);
-                break;
-            case 5:
-                // POI-SENSOR (PS) STAGE
-                has_edges = 1;
-                stage = this->parse_edge(stage, token);
-                break;
-            case 6:
-                // SENSOR-SENSOR (SS) STAGE
-                has_edges = 1;
-                stage = this->parse_edge(stage, token);
-                break;
-            case 7:
-                // SENSOR-SINK (SK) STAGE
-                has_edges = 1;
-                stage = this->parse_edge(stage, token);
-                break;
-            case 8:
-                // END-STAGE
-                break;
-            default: throw std::runtime_error("FORBIDDEN STAGE!");
+            default:
+                // STAGE TAGS. The END tag finishes the parsing
+                if      (token_is(first, cursor, "PS"))  {stage = 5; has_edges = true;}
+                else if (token_is(first, cursor, "SS"))  {stage = 6; has_edges = true;}
+                else if (token_is(first, cursor, "SK"))  {stage = 7; has_edges = true;}
+                else if (token_is(first, cursor, "END")) {stage = 8;}
+                else if (stage == 4) {throw std::runtime_error("UNKNOWN TOKEN!");}
+
+                // EDGE at the POI-SENSOR (PS), SENSOR-SENSOR (SS) or SENSOR-SINK (SK) stages
+                else {
+                    first = parse_integer(first, cursor, source);
+                    parse_integer(first, cursor, target);
+                    switch (stage) {
+                        case 5:
+                            this->ps_edges.emplace_back(source, target);
+                            break;
+                        case 6:
+                            this->ss_edges.emplace_back(source, target);
+                            this->ss_edges.emplace_back(target, source);
+                            break;
+                        case 7:
+                            this->sk_edges.emplace_back(source, target);
+                            break;
+                        default: throw std::runtime_error("FORBIDDEN STAGE!");
+                    }
+                }
         }
-        previous = pos+1;
+        first = token_end + 1;
     }
+    if (stage < 4) {throw std::runtime_error("INSTANCE IS TRUNCATED!");}
     if (this->num_pois == 0) {throw std::runtime_error("INSTANCE HAS NO POIS!");}
     if (this->num_sensors == 0) {throw std::runtime_error("INSTANCE HAS NO SENSORS!");}
     if (this->num_sinks == 0) {throw std::runtime_error("INSTANCE HAS NO SINKS!");}
 
-    // If we got here and have no edges, we must re-generate this instance
-    if (has_edges == 0) { this->regenerate(); }
-}
-
-
-/** Utility method to the De-Serializer Constructor
- */
-int KCMC_Instance::parse_edge(const int stage, const std::string& token){
-    /* Instance de-serializer helper method. Parses a single edge */
-
-    // Parse the stage itself
-    std::unordered_set<std::string> tags = {"PS", "SS", "SK", "END"};
-    if (isin(tags, token)){
-        if      (token == "PS"){return 5;}
-        else if (token == "SS"){return 6;}
-        else if (token == "SK"){return 7;}
-        else if (token == "END"){return 8;}
-    } else if (stage == 4) {throw std::runtime_error("UNKNOWN TOKEN!");}
-
-    // Parsing at the current stage
-    std::stringstream s_token(token);
-    int source, target;
-    s_token >> source;
-    s_token >> target;
-    switch (stage) {
-        case 5:
-            push(this->poi_sensor, source, target);
-            push(this->sensor_poi, target, source);
-            return 5;
-        case 6:
-            push(this->sensor_sensor, source, target);
-            push(this->sensor_sensor, target, source);
-            return 6;
-        case 7:
-            push(this->sensor_sink, source, target);
-            push(this->sink_sensor, target, source);
-            return 7;
-        case 8: return 8;
-        default: throw std::runtime_error("FORBIDDEN STAGE!");
+    /* If we got here and have no edges, we must re-generate this instance (unless it is in the instance cache).
+     * Else, compact the parsed edges */
+    if (not has_edges) {
+        if (not this->load_cached()) {
+            this->regenerate();
+            this->store_cached();
+        }
     }
+    else { this->build_graph(); }
 }
 
 
@@ -255,11 +563,26 @@ int KCMC_Instance::parse_edge(const int stage, const std::string& token){
  * Gets the coverage at each POI, and the number of POIs with any coverage at all
  */
 int KCMC_Instance::get_coverage(int buffer[], std::unordered_set<int> &inactive_sensors) {
+    return this->get_coverage(buffer, SensorSet(this->num_sensors, inactive_sensors));
+}
+int KCMC_Instance::get_coverage(int buffer[], const SensorSet &inactive_sensors) {
+    inactive_sensors.require_width(this->num_sensors);
+    const PoiClasses &classes = this->poi_classes();
+    bool use_matrix = this->coverage_matrix.fits(inactive_sensors);
 
-    // For each POI, count its coverage and if it has coverage at all
+    // For each POI, count its coverage and if it has coverage at all. Only class representatives are counted
     int has_coverage = 0;
     for (int n_poi=0; n_poi < this->num_pois; n_poi++) {
-        buffer[n_poi] = (int)(set_diff(poi_sensor[n_poi], inactive_sensors).size());
+        if (not classes.is_representative(n_poi)) {buffer[n_poi] = buffer[classes.representative[classes.of_poi[n_poi]]];}
+        else if (use_matrix and this->coverage_matrix.pays_off(this->poi_sensor[n_poi].size())) {
+            buffer[n_poi] = this->coverage_matrix.coverage(n_poi, inactive_sensors);
+        }
+        else {
+            buffer[n_poi] = 0;
+            for (const int &a_sensor : this->poi_sensor[n_poi]) {
+                if (not inactive_sensors.contains(a_sensor)) {buffer[n_poi]++;}
+            }
+        }
         has_coverage += buffer[n_poi] > 0 ? 1 : 0;
     }
 
@@ -276,7 +599,10 @@ int KCMC_Instance::get_degree(int buffer[], std::unordered_set<int> &inactive_se
     // For each Sensor, count its coverage, returning the number of sensors with any conection at all
     int has_connection = 0;
     for (int n_sensor=0; n_sensor < this->num_sensors; n_sensor++) {
-        buffer[n_sensor] = (int)(set_diff(sensor_sensor[n_sensor], inactive_sensors).size());
+        buffer[n_sensor] = 0;
+        for (const int &neighbor : this->sensor_sensor[n_sensor]) {
+            if (not isin(inactive_sensors, neighbor)) {buffer[n_sensor]++;}
+        }
         has_connection += 1;
     }
 
@@ -297,48 +623,90 @@ std::string KCMC_Instance::key() const {
 }
 
 
-/** Instance serializer
+/** Instance file identification utility
  */
-std::string KCMC_Instance::serialize() {
-    /* Serializes an instance as an string */
-    int source, target;
-
+std::string KCMC_Instance::file_key() const {
+    /* Returns the settings KEY of the instance, in a form that can be used as a file name */
     std::ostringstream out;
-    out << "KCMC;" << this->key() << ';';
+    out << num_pois  <<'_'<< num_sensors            <<'_'<< num_sinks                   << '-';
+    out << area_side <<'_'<< sensor_coverage_radius <<'_'<< sensor_communication_radius << '-';
+    out << random_seed;
+    return out.str();
+}
+
+
+/** Utility to the Serializer
+ * Appends the decimal representation of an integer to the buffer, with no intermediate string
+ */
+void append_integer(std::string &buffer, long long value) {
+    char digits[24];
+    int length = 0;
+    unsigned long long magnitude = (value < 0) ? (0ULL - (unsigned long long)value) : (unsigned long long)value;
+    do {digits[length++] = (char)('0' + (magnitude % 10)); magnitude /= 10;} while (magnitude > 0);
+    if (value < 0) {buffer.push_back('-');}
+    while (length > 0) {buffer.push_back(digits[--length]);}
+}
+
+
+/** Instance serializer
+ * Walks the sorted rows of each adjacency once, so the edges are written in deterministic order in O(E) time.
+ * Writes into the given buffer. If a stream is also given, the buffer is flushed to it every time it grows large
+ */
+void KCMC_Instance::serialize(std::string &buffer, std::ostream *out) {
+    int source;
+    const size_t flush_size = 1 << 16;
+
+    // Write a single edge, flushing the buffer to the stream if needed
+    auto write_edge = [&buffer, out, flush_size](int edge_source, int edge_target) {
+        append_integer(buffer, edge_source);
+        buffer.push_back(' ');
+        append_integer(buffer, edge_target);
+        buffer.push_back(';');
+        if ((out != nullptr) and (buffer.size() >= flush_size)) {out->write(buffer.data(), buffer.size()); buffer.clear();}
+    };
+
+    buffer.append("KCMC;");
+    buffer.append(this->key());
+    buffer.push_back(';');
 
     // Set the poi-sensor connections
-    out << "PS;";
+    buffer.append("PS;");
     for (source=0; source<num_pois; source++) {
-        for (target=0; target<num_sensors; target++) {
-            if (isin(poi_sensor[source], target)) {
-                out << source << ' ' << target << ';';  // MUCH SLOWER than iterating the hashmap, but deterministic
-            }
-        }
+        for (const int &target : this->poi_sensor[source]) {write_edge(source, target);}
     }
 
-    // Set the sensor-sensor connections
-    out << "SS;";
+    // Set the sensor-sensor connections, once for each pair (from the smallest index to the largest)
+    buffer.append("SS;");
     for (source=0; source<num_sensors; source++) {
-        for (target=source; target<num_sensors; target++) {
-            if (isin(this->sensor_sensor[source], target)) {
-                out << source << ' ' << target << ';';  // MUCH SLOWER than iterating the hashmap, but deterministic
-            }
+        for (const int &target : this->sensor_sensor[source]) {
+            if (target >= source) {write_edge(source, target);}
         }
     }
 
     // Set the sensor-sink connections
-    out << "SK;";
+    buffer.append("SK;");
     for (source=0; source<num_sensors; source++) {
-        for (target=0; target<num_sinks; target++) {
-            if (isin(this->sensor_sink[source], target)) {
-                out << source << ' ' << target << ';';  // MUCH SLOWER than iterating the hashmap, but deterministic
-            }
-        }
+        for (const int &target : this->sensor_sink[source]) {write_edge(source, target);}
     }
 
-    // Return the out string
-    out << "END";
-    return out.str();
+    // Finish the buffer
+    buffer.append("END");
+    if (out != nullptr) {out->write(buffer.data(), buffer.size()); buffer.clear();}
+}
+void KCMC_Instance::serialize(std::ostream &out) {
+    /* Serializes an instance into an output stream */
+    std::string buffer;
+    buffer.reserve(1 << 17);
+    this->serialize(buffer, &out);
+}
+std::string KCMC_Instance::serialize() {
+    /* Serializes an instance as an string, pre-reserving about 12 characters per edge */
+    std::string buffer;
+    buffer.reserve(64 + 12 * (size_t)(this->poi_sensor.num_edges()
+                                      + this->sensor_sensor.num_edges() / 2
+                                      + this->sensor_sink.num_edges()));
+    this->serialize(buffer, nullptr);
+    return buffer;
 }
 
 int KCMC_Instance::invert_set(std::unordered_set<int> &source_set, std::unordered_set<int> *target_set) {
@@ -356,12 +724,26 @@ bool KCMC_Instance::validate(const bool raise, const int k, const int m,
                              std::unordered_set<int> &inactive_sensors,
                              std::unordered_set<int> *k_used_sensors,
                              std::unordered_set<int> *m_used_sensors) {
-    int valid;
-
+    return this->validate(raise, k, m, SensorSet(this->num_sensors, inactive_sensors), k_used_sensors, m_used_sensors);
+}
+bool KCMC_Instance::validate(const bool raise, const int k, const int m,
+                             const SensorSet &inactive_sensors,
+                             std::unordered_set<int> *k_used_sensors,
+                             std::unordered_set<int> *m_used_sensors) {
+    SensorSet k_used_bitset;
+    bool valid = this->validate(raise, k, m, inactive_sensors, &k_used_bitset, m_used_sensors);
+    k_used_bitset.to_set(*k_used_sensors);
+    return valid;
+}
+bool KCMC_Instance::validate(const bool raise, const int k, const int m,
+                             const SensorSet &inactive_sensors,
+                             SensorSet *k_used_sensors,
+                             std::unordered_set<int> *m_used_sensors) {
     // Check validity, recovering the used sensors for K coverage and M connectivity
     try {
-        valid = this->fast_k_coverage(k, inactive_sensors, k_used_sensors);
-        if (valid != -1) { throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)"); }
+        if (not this->check_k_coverage(k, inactive_sensors, k_used_sensors, nullptr).ok()) {
+            throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)");
+        }
     }
     catch (const std::exception &exc) {
         if (raise) {throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)");}
@@ -369,8 +751,10 @@ bool KCMC_Instance::validate(const bool raise, const int k, const int m,
     }
 
     try {
-        valid = this->fast_m_connectivity(m, inactive_sensors, m_used_sensors);
-        if (valid != -1) { throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT CONNECTIVITY)"); }
+        std::unordered_map<int, int> m_votes;
+        bool connected = this->check_m_connectivity(m, inactive_sensors, &m_votes).ok();
+        setify(*m_used_sensors, &m_votes);
+        if (not connected) { throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT CONNECTIVITY)"); }
     }
     catch (const std::exception &exc) {
         if (raise) {throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT CONNECTIVITY)");}
@@ -381,14 +765,18 @@ bool KCMC_Instance::validate(const bool raise, const int k, const int m,
 
 bool KCMC_Instance::validate(const bool raise, const int k, const int m,
                              std::unordered_set<int> &inactive_sensors) {
-    // Prepare the ignored results buffer and the empty set of inactive sensors
-    std::unordered_set<int> ignored;
-    return this->validate(raise, k, m, inactive_sensors, &ignored, &ignored);
+    return this->validate(raise, k, m, SensorSet(this->num_sensors, inactive_sensors));
+}
+bool KCMC_Instance::validate(const bool raise, const int k, const int m, const SensorSet &inactive_sensors) {
+    // Prepare the ignored results buffers
+    SensorSet ignored_k;
+    std::unordered_set<int> ignored_m;
+    return this->validate(raise, k, m, inactive_sensors, &ignored_k, &ignored_m);
 }
 
 
 bool KCMC_Instance::validate(const bool raise, const int k, const int m) {
-    // Prepare the ignored results buffer and the empty set of inactive sensors
-    std::unordered_set<int> emptyset;
+    // Prepare the empty set of inactive sensors
+    SensorSet emptyset(this->num_sensors);
     return this->validate(raise, k, m, emptyset);
 }
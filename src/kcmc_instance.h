@@ -8,7 +8,20 @@
 #include <vector>         // vector object
 #include <unordered_set>  // unordered_set object
 #include <unordered_map>  // unordered_map HashMap object
+#include <utility>        // pair
+#include <cstdint>        // uint64_t, int32_t, int64_t
+#include <memory>         // shared_ptr, unique_ptr
+#include <string>         // string
+#include <istream>        // istream
+#include <ostream>        // ostream
 #include <cmath>          // sqrt, pow
+#include <functional>     // function
+#include <algorithm>      // fill
+#include <mutex>          // mutex
+#include <thread>         // thread
+#include <deque>          // deque
+#include <condition_variable>  // condition_variable
+#include <exception>      // exception_ptr
 
 
 #ifndef KCMC_INSTANCE_H
@@ -56,12 +69,151 @@ struct Placement {
 double distance(Placement source, Placement target);
 
 
+/* UNIFORM GRID
+ * Spatial index of placements in square cells of side at least a search radius (and large enough to keep about as
+ *   many cells as placements), over the instance area.
+ * Every placement within the radius of a point is either in the cell of the point or in one of its 8 neighbors.
+ * Cells are stored as contiguous runs of placement indexes (counting sort), in increasing index order.
+ */
+
+
+struct UniformGrid {
+    int cell_side, cells_per_row;
+    std::vector<int> cell_offsets, cell_items;
+
+    void build(const Placement *placements, int size, int radius, int area_side);
+    int cell_of(int coordinate) const {
+        int cell = coordinate / cell_side;
+        return (cell < 0) ? 0 : ((cell >= cells_per_row) ? cells_per_row-1 : cell);
+    }
+};
+
+
+/* CSR ADJACENCY
+ * Read-optimized Compressed-Sparse-Row adjacency of a bipartite (or self) relation between nodes.
+ * The neighbors of source node i are stored contiguously and sorted at neighbors()[offsets()[i]:offsets()[i+1]].
+ * It is built once, from a list of (source, target) edges or streamed row by row, and is read-only afterwards.
+ * It may also be attached to arrays it does not own (i.e. a memory-mapped binary instance), with no copies at all.
+ * Indexing the adjacency returns a Neighbors range, that can be iterated, sized and searched like the old sets.
+ */
+
+
+struct Neighbors {
+    const int *first, *last;
+    const int *begin() const {return first;}
+    const int *end() const {return last;}
+    size_t size() const {return (size_t)(last - first);}
+    bool empty() const {return first == last;}
+};
+
+class CSR_Adjacency {
+    public:
+        CSR_Adjacency() : rows(0), offset_view(nullptr), neighbor_view(nullptr) {}
+        CSR_Adjacency(const CSR_Adjacency &other);
+        CSR_Adjacency &operator=(const CSR_Adjacency &other);
+
+        void build(int num_sources, std::vector<std::pair<int, int>> &edges, bool transpose);
+        void build(int num_sources, const std::function<void(int, std::vector<int> &)> &append_row);
+        void attach(int num_sources, const int *offsets, const int *neighbors);
+        void clear();
+        int num_sources() const {return rows;}
+        int num_edges() const {return (rows == 0) ? 0 : offset_view[rows];}
+        const int *offsets() const {return offset_view;}
+        const int *neighbors() const {return neighbor_view;}
+        int degree(int source) const {return offset_view[source+1] - offset_view[source];}
+        bool has(int source, int target) const;
+        Neighbors operator[](int source) const {
+            return {neighbor_view + offset_view[source], neighbor_view + offset_view[source+1]};
+        }
+
+    private:
+        int rows;
+        const int *offset_view, *neighbor_view;
+        std::vector<int> offset_storage, neighbor_storage;
+        bool owns_storage() const {return offset_view == offset_storage.data();}
+};
+
+
+/* BINARY INSTANCE FORMAT
+ * Versioned, memory-mappable representation of an instance: a fixed-size header with the instance key fields and
+ * the number of entries of each adjacency, followed by the raw CSR arrays (int32, host byte order) of poi_sensor,
+ * sensor_poi, sensor_sensor, sensor_sink and sink_sensor, in this order, each as its offsets then its neighbors.
+ * A mapped file is shared, read-only, between every instance (and process) that loads it.
+ */
+
+
+#define KCMC_BINARY_MAGIC "KCMCBIN"
+#define KCMC_BINARY_VERSION 1
+#define KCMC_BINARY_BYTE_ORDER 0x01020304
+
+struct KCMC_BinaryHeader {
+    char magic[8];
+    uint32_t version, byte_order;
+    int32_t num_pois, num_sensors, num_sinks, area_side, sensor_coverage_radius, sensor_communication_radius;
+    int64_t random_seed;
+    int64_t num_poi_sensor, num_sensor_sensor, num_sensor_sink;  // Entries in each direction of each relation
+};
+
+class MappedFile {
+    public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        const char *data() const {return address;}
+        size_t size() const {return length;}
+
+    private:
+        const char *address;
+        size_t length;
+};
+
+bool is_binary_instance(const std::string &path);
+
+
+/* SENSOR SET
+ * Fixed-width dynamic bitset of sensor indexes, one bit per sensor of the instance, packed in 64-bit words.
+ * Membership is a shift-and-mask, and copying a set of the same width is a plain copy of num_sensors/64 words.
+ * Used as the dense alternative to unordered sets of inactive/used sensors in the innermost loops.
+ * Every service taking a set of inactive sensors requires its width to be the number of sensors of the instance, and
+ *   throws (see require_width) otherwise, as contains() itself does no bounds check.
+ */
+
+
+class SensorSet {
+    public:
+        std::vector<uint64_t> words;
+
+        SensorSet() : width(0) {}
+        explicit SensorSet(int width) : words((width + 63) / 64, 0), width(width) {}
+        SensorSet(int width, const std::unordered_set<int> &source);
+
+        int size() const {return width;}
+        int count() const;
+        bool empty() const {for (const uint64_t &word : words) {if (word != 0) {return false;}} return true;}
+        void clear() {std::fill(words.begin(), words.end(), 0);}
+        void resize(int new_width) {width = new_width; words.assign((new_width + 63) / 64, 0);}
+        bool contains(int item) const {return (words[item >> 6] >> (item & 63)) & 1ULL;}
+        void insert(int item) {words[item >> 6] |= (1ULL << (item & 63));}
+        void erase(int item) {words[item >> 6] &= ~(1ULL << (item & 63));}
+        void to_set(std::unordered_set<int> &target) const;
+        void require_width(int expected) const;
+
+    private:
+        int width;
+};
+
+
 /* ISIN
  * Many-types-of-input verification if a given item is in the reference set.
  * If the reference set is a mapping, the search is in its keys.
+ * If the reference set is an adjacency, the search is for an item that has any neighbor at all.
  */
 
 
+bool isin(const CSR_Adjacency &ref, int item);
+bool isin(const SensorSet &ref, int item);
+bool isin(const Neighbors &ref, int item);
 bool isin(std::unordered_map<int, std::unordered_set<int>> &ref, int item);
 bool isin(std::unordered_map<int, int> &ref, int item);
 bool isin(std::unordered_set<int> &ref, int item);
@@ -93,12 +245,254 @@ std::unordered_set<int> set_diff(const std::unordered_set<int> &left, const std:
  * Returns a set from other data structure
  */
 void setify(std::unordered_set<int> &target, int size, int source[], int reference);
+void setify(SensorSet &target, int size, int source[], int reference);
 void setify(std::unordered_set<int> &target, std::unordered_map<int, int> *reference);
 
 
+/* CHECK RESULT
+ * Result of a k-coverage or m-connectivity check: the first POI short of the requirement (-1 if none) with its
+ *   coverage or number of disjoint paths, and the total number of paths found (64-bit, as it grows with POIs x M).
+ * The int results of the fast_* services pack the same values as (poi*1000000)+count, which only holds below a
+ *   million POIs and paths. The check_* services return this structure instead, with no such limits
+ */
+
+
+struct CheckResult {
+    int failing_poi = -1, found = 0;
+    long long total_paths = 0;
+    bool ok() const {return failing_poi == -1;}
+};
+
+
+/* POI CLASSES
+ * Equivalence classes of the POIs of an instance with identical covering sensors (poi_sensor rows).
+ * The coverage and the disjoint paths of a POI depend only on its covering sensors, so every POI of a class has the
+ *   same results, and only the first POI of the class (its representative) has to be evaluated.
+ * Classes are numbered in the order of their representatives, so the first POI to fail any check is always the
+ *   representative of the first class to fail it.
+ */
+
+
+struct PoiClasses {
+    std::vector<int> of_poi, representative;
+    int size() const {return (int)representative.size();}
+    bool is_representative(int poi) const {return representative[of_poi[poi]] == poi;}
+};
+
+
+/* RUN PARALLEL
+ * Splits [0, size) in num_threads contiguous blocks, and runs task(thread, begin, end) for each block in its own thread.
+ * The first block runs in the calling thread. Returns after every block is done, rethrowing the first exception
+ */
+void run_parallel(int size, int num_threads, const std::function<void(int, int, int)> &task);
+
+
+/* WORK STEALING POOL
+ * Long-lived worker threads running the submitted tasks. Each worker has its own deque. A task submitted by a running
+ *   task goes to the back of its worker's deque, and a task submitted from outside the pool is dealt to the deques in
+ *   turn. A worker runs the newest task of its own deque (LIFO, while its data is hot), or steals the oldest task of
+ *   another deque (FIFO, the one most likely to spawn more work) when its own is empty. A worker that finds no task
+ *   sleeps until one is submitted.
+ * wait() returns after every task submitted so far is done, including the tasks they submitted, rethrowing the first
+ *   exception of any of them. It must not be called from a task. The destructor waits for the pending tasks, and
+ *   joins the workers
+ */
+class WorkStealingPool {
+    public:
+        explicit WorkStealingPool(int num_workers);
+        ~WorkStealingPool();
+        void submit(std::function<void()> task);
+        void wait();
+        int size() const {return (int)this->workers.size();}
+
+    private:
+        struct TaskDeque {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+        std::vector<std::unique_ptr<TaskDeque>> deques;
+        std::vector<std::thread> workers;
+        std::mutex state_lock;                            // Guards the counters below, and the first error
+        std::condition_variable work_ready, all_done;
+        int queued = 0, running = 0, next_deque = 0;     // Tasks in the deques, tasks taken and not yet done
+        bool stopping = false;
+        std::exception_ptr error;
+        static thread_local WorkStealingPool *current_pool;
+        static thread_local int current_worker;
+        bool take(int worker, std::function<void()> &task);
+        void work(int worker);
+};
+
+
+/* COVERAGE MATRIX
+ * Dense POI x sensor coverage bit-matrix. The row of each POI has the bit of every sensor covering it set.
+ * The coverage of a POI under a set of inactive sensors is then the popcount of its row AND NOT the inactive bitset,
+ *   word by word, using AVX-512 or AVX2 kernels when the library is built for a target that has them.
+ * It takes num_pois * num_sensors / 8 bytes, so it is only built on request.
+ * fits() tells if a set of inactive sensors has the exact width of the rows, as required by the kernels.
+ * A row only pays off over the poi-sensor edges of its POI when it has fewer words than edges, so sparse POIs are
+ *   still counted from the adjacency, and worth_building() tells if the average POI of an instance is dense enough.
+ */
+
+
+class CoverageMatrix {
+    public:
+        CoverageMatrix() : rows(0), columns(0), words_per_row(0) {}
+
+        void build(const CSR_Adjacency &poi_sensor, int num_sensors);
+        void clear();
+        bool empty() const {return rows == 0;}
+        bool fits(const SensorSet &inactive_sensors) const {
+            return (rows > 0) and (inactive_sensors.size() == columns)
+                   and (inactive_sensors.words.size() == (size_t)words_per_row);
+        }
+        size_t num_words() const {return (size_t)rows * words_per_row;}
+        bool pays_off(size_t num_edges) const {return num_edges > (size_t)words_per_row;}
+        static bool worth_building(const CSR_Adjacency &poi_sensor, int num_sensors) {
+            return (long long)(poi_sensor.num_edges()) > (long long)(poi_sensor.num_sources()) * ((num_sensors + 63) / 64);
+        }
+        int coverage(int poi, const SensorSet &inactive_sensors) const;
+        int coverage(int buffer[], const SensorSet &inactive_sensors) const;
+
+    private:
+        int rows, columns, words_per_row;
+        std::vector<uint64_t> bits;
+};
+
+
+/* DISJOINT PATHS FLOW
+ * Exact engine for the number of node-disjoint paths from a POI to the sinks: unit-capacity Dinic's algorithm on a
+ *   flow network where each sensor is split in an entry and an exit node joined by an edge of capacity 1.
+ * Unlike the greedy path finder, it augments along residual edges, so it never misses a set of disjoint paths.
+ * It is built once for a graph, and its residual network is restored after each POI by touching only the edges that
+ *   carried flow, so evaluating every POI under many sets of inactive sensors allocates nothing.
+ * The connectivity method of the instance selects between the greedy (CONN_GREEDY) and the exact (CONN_EXACT) engine
+ */
+
+#define CONN_GREEDY 0
+#define CONN_EXACT 1
+
+
+/* BUCKET QUEUE
+ * Priority queue of the path finder: pops the sensor of lowest key, and of highest index among equal keys (the same
+ *   order as a heap of LevelNodes with CompareLevelNode).
+ * The keys of a search are small integers near each other (hop levels, or inverse frequencies in reuse), so they are
+ *   kept in a window of buckets, one for each key, each a small heap of sensor indices. Keys may go down as well as
+ *   up, as the lowest non-empty bucket is tracked on every push and pop. Keys out of the window (i.e. unreachable
+ *   sensors, or a search drifting far from its first key) fall back to heaps of LevelNodes below and above it.
+ * The window is placed around the first key pushed into the empty queue, and the buckets keep their storage.
+ */
+class BucketQueue {
+    public:
+        BucketQueue() : buckets(WINDOW), offset(0), lowest(WINDOW), in_buckets(0) {}
+        bool empty() const {return (in_buckets == 0) and below.empty() and above.empty();}
+        void clear();
+        void push(int index, int key);
+        int pop();
+
+    private:
+        static const int WINDOW = 256;
+        std::vector<std::vector<int>> buckets;
+        std::vector<LevelNode> below, above;
+        int offset, lowest, in_buckets;
+};
+
+
+/* SEARCH WORKSPACE
+ * Reusable buffers of the path finder: the predecessor of each visited sensor and the storage of the priority queue.
+ * Each predecessor is stamped with the epoch of the search that set it, so starting a new search only advances the
+ *   epoch, and any sensor not visited in the current search reads as -2 (no predecessor), with no reset of the arrays.
+ */
+class SearchWorkspace {
+    public:
+        BucketQueue queue;
+
+        SearchWorkspace() : epoch(0) {}
+        void start(int size) {
+            if ((int)stamps.size() != size) {stamps.assign(size, 0); predecessors.resize(size); epoch = 0;}
+            if (++epoch == 0) {std::fill(stamps.begin(), stamps.end(), 0); epoch = 1;}  // Wrapped around
+            queue.clear();
+        }
+        bool visited(int sensor) const {return stamps[sensor] == epoch;}
+        int predecessor(int sensor) const {return visited(sensor) ? predecessors[sensor] : -2;}
+        void visit(int sensor, int predecessor) {stamps[sensor] = epoch; predecessors[sensor] = predecessor;}
+
+    private:
+        uint32_t epoch;
+        std::vector<uint32_t> stamps;
+        std::vector<int> predecessors;
+};
+
+
+/* PATH SCRATCH
+ * Per-thread buffers of the greedy path finder: the sensors used by the paths of the current POI and the search
+ */
+struct PathScratch {
+    SensorSet used_sensors;
+    SearchWorkspace search;
+};
+
+
+/* WORKSPACE
+ * Reusable per-sensor buffers of the preprocessors: the level graph (flood) or the inverse frequency array (reuse),
+ *   the sensors used by the paths of the current POI, and the path search buffers.
+ * Owned by the caller, one for each thread, and sized on use, so calls in sequence allocate nothing and the instance
+ *   size is limited only by memory. The preprocessors that take no workspace use one owned by the instance.
+ * The best reuse runs its variants at once on a pool of three workers shared by every instance: the first in this
+ *   workspace, and the others in the nested ones.
+ */
+struct KCMC_Workspace {
+    std::vector<int> levels;
+    SensorSet used_sensors;
+    SearchWorkspace search;
+    std::vector<KCMC_Workspace> variants;
+};
+
+
+class DisjointPathsFlow {
+    public:
+        DisjointPathsFlow() : num_sensors(0), source(0), sink(0) {}
+
+        void build(int num_sensors, const CSR_Adjacency &sensor_sensor, const CSR_Adjacency &sensor_sink);
+        void clear();
+        bool empty() const {return offsets.empty();}
+        void set_inactive(const SensorSet &inactive_sensors);
+        int max_paths(const Neighbors &covering_sensors, int limit, std::vector<int> *used_sensors);
+
+    private:
+        int num_sensors, source, sink;
+        std::vector<int> offsets, targets, reverse, capacity, base_capacity, split_edges, source_edges;
+        std::vector<int> levels, current, work_queue, touched;
+        bool build_levels();
+        bool augment();
+};
+
+
+/* CONNECTIVITY SCRATCH
+ * Buffers of one connectivity evaluation: the scratch of the greedy path finder and the exact disjoint paths engine
+ *   of each of its threads, the level graph they share and the buffers of its search, and the results of each class.
+ * The instance keeps a pool of them, and each evaluation leases one for its duration, so concurrent evaluations of
+ *   the same instance (e.g. by the tasks of a scheduler) never share buffers, and evaluations in sequence allocate
+ *   nothing once the pool is warm. This is why the connectivity services take no workspace: unlike the preprocessor
+ *   buffers, a scratch is never handed back to the caller, so the instance can own and reuse it. The flow networks are
+ *   built on the first exact evaluation of the graph that leases the scratch.
+ */
+struct ConnectivityScratch {
+    std::vector<PathScratch> paths;
+    std::vector<DisjointPathsFlow> flows;
+    std::vector<int> levels, level_round, work_set, next_set;
+    SensorSet visited;
+    std::vector<int> class_paths, class_thread, used_begin, used_end;
+    std::vector<std::vector<int>> block_used;
+};
+
+
 // #####################################################################################################################
 
 
+struct ConnectivityCertificate;
+
+
 /** KCMC Instance Object
  * Contains node vectors for pois, sensors, sinks.
  * Vector of unordered sets listing the neighbors of each poi, sensor and sink
@@ -124,13 +518,25 @@ class KCMC_Instance {
         std::vector<Node> poi, sensor, sink;
 
         /* Graph edges sparse matrix
-         * Separate HashMaps of UnorderedSet of indexes of Nodes for poi-sensor, sensor-sensor and sensor-sink edges.
-         * Each HashMap contains an UnorderedSet of indexes of Nodes. The index in the HashMap is relative to the
-         *     index of the base Node it represents. The content of the HashMap is an unordered set of the indexes of
-         *     the Nodes that the index node is neighbor of.
+         * Separate CSR adjacencies of indexes of Nodes for poi-sensor, sensor-sensor and sensor-sink edges.
+         * Each adjacency has a row for every Node of its source type. The row of a Node is the sorted array of
+         *     indexes of the Nodes that the source node is neighbor of.
          * There are no Poi-Poi, Poi-Sink nor Sink-Sink edges
          */
-        std::unordered_map<int, std::unordered_set<int>> poi_sensor, sensor_poi, sensor_sensor, sensor_sink, sink_sensor;
+        CSR_Adjacency poi_sensor, sensor_poi, sensor_sensor, sensor_sink, sink_sensor;
+
+        /* Optional dense coverage matrix
+         * Empty unless build_coverage_matrix() is called. While built, it backs get_coverage and fast_k_coverage for
+         * the POIs with more covering sensors than words in their row.
+         * It is dropped whenever the graph changes (i.e. the instance is reseeded)
+         */
+        CoverageMatrix coverage_matrix;
+        void build_coverage_matrix();
+
+        /* POI equivalence classes by covering sensors, computed on first use and dropped whenever the graph changes.
+         * The validators, get_coverage, get_connectivity and flood evaluate each class once
+         */
+        const PoiClasses &poi_classes();
 
         /* Random-instance generator constructor
          * Receives the instance descriptive constants and makes an instance of randomly-placed Nodes.
@@ -139,25 +545,46 @@ class KCMC_Instance {
                       int area_side, int coverage_radius, int communication_radius,
                       long long random_seed);
 
-        /* Instance de-serializes constructor
-         * Receives a serialized instance and constructs an KCMC_Instance object from it.
+        /* Instance de-serializes constructors
+         * Receives a serialized instance (or a stream to read it from) and constructs an KCMC_Instance object from it.
          */
         explicit KCMC_Instance(const std::string& serialized_kcmc_instance);
+        explicit KCMC_Instance(std::istream &serialized_kcmc_instance);
+
+        /* Instance loader
+         * Receives a serialized instance, "-" for an instance in STDIN, or the path of a text or binary instance file,
+         * and returns a new instance.
+         * Binary instances are memory-mapped, and their adjacencies are read directly from the mapped file.
+         */
+        static KCMC_Instance *load(const std::string &source);
 
         /* Instance basic services
+         * Regenerate the instance in place for another random seed, reusing all of its buffers
          * Get the KEY of the current instance
          * Serialize the current instance as a string
          * Invert a set of sensors (get every sensor in the instance not in the set)
          * Validate the instance, raising errors if invalid. Some arguments are optional
          */
+        void reseed(long long random_seed);
         std::string key() const;
         std::string serialize();
+        void serialize(std::ostream &out);
+        void serialize(std::string &buffer, std::ostream *out);
+        std::string file_key() const;
+        void write_binary(const std::string &path);
         int invert_set(std::unordered_set<int> &source_set, std::unordered_set<int> *target_set);
         bool validate(bool raise, int k, int m);
         bool validate(bool raise, int k, int m, std::unordered_set<int> &inactive_sensors);
         bool validate(bool raise, int k, int m, std::unordered_set<int> &inactive_sensors,
                       std::unordered_set<int> *k_used_sensors,
                       std::unordered_set<int> *m_used_sensors);
+        bool validate(bool raise, int k, int m, const SensorSet &inactive_sensors);
+        bool validate(bool raise, int k, int m, const SensorSet &inactive_sensors,
+                      std::unordered_set<int> *k_used_sensors,
+                      std::unordered_set<int> *m_used_sensors);
+        bool validate(bool raise, int k, int m, const SensorSet &inactive_sensors,
+                      SensorSet *k_used_sensors,
+                      std::unordered_set<int> *m_used_sensors);
 
         /* Instance problem-specific methods
          * Get the Degree of each Sensor in the instance
@@ -168,10 +595,16 @@ class KCMC_Instance {
         int get_coverage(int buffer[], std::unordered_set<int> &inactive_sensors);
         int get_connectivity(int buffer[], std::unordered_set<int> &inactive_sensors, int target);
         int get_connectivity(int buffer[], std::unordered_set<int> &inactive_sensors);
+        int get_coverage(int buffer[], const SensorSet &inactive_sensors);
+        int get_connectivity(int buffer[], const SensorSet &inactive_sensors, int target);
+        int get_connectivity(int buffer[], const SensorSet &inactive_sensors);
 
         /* Instance payload services
-         * Validates k-coverage in the instance considering the given set of inactive sensors
-         * Validates m-connectivity in the instance considering the given set of inactive sensors
+         * Validates k-coverage in the instance considering the given set of inactive sensors, optionally getting the
+         *   coverage deficit of every POI
+         * Validates m-connectivity in the instance considering the given set of inactive sensors, either with greedy
+         *   disjoint paths or with the exact max-flow engine
+         * Every service that takes a set of inactive sensors also takes it as a SensorSet bitset, which is faster
          */
         int fast_k_coverage(int k, std::unordered_set<int> &inactive_sensors);
         int fast_k_coverage(int k, std::unordered_set<int> &inactive_sensors, std::unordered_set<int> *all_used_sensors);
@@ -179,6 +612,50 @@ class KCMC_Instance {
         int fast_m_connectivity(int m, std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *all_used_sensors);
         int fast_m_connectivity(int m, std::unordered_set<int> &inactive_sensors, std::unordered_set<int> *all_used_sensors);
         std::string m_connectivity(int m, std::unordered_set<int> &inactive_sensors);
+        int fast_k_coverage(int k, const SensorSet &inactive_sensors);
+        int fast_k_coverage(int k, const SensorSet &inactive_sensors, std::unordered_set<int> *all_used_sensors);
+        int fast_k_coverage(int k, const SensorSet &inactive_sensors, SensorSet *all_used_sensors, std::vector<int> *deficits);
+        int fast_m_connectivity(int m, const SensorSet &inactive_sensors, std::unordered_map<int, int> *all_used_sensors);
+        int fast_m_connectivity(int m, const SensorSet &inactive_sensors, std::unordered_set<int> *all_used_sensors);
+        int exact_m_connectivity(int m, const SensorSet &inactive_sensors, std::unordered_map<int, int> *all_used_sensors);
+        int exact_connectivity(int buffer[], const SensorSet &inactive_sensors, int target);
+
+        /* Certified connectivity services
+         * Same results as the services above, also keeping in the certificate the disjoint paths found for each POI.
+         * A certificate from a previous call (with the same m or target) is reused under another set of inactive
+         *   sensors. With exact paths, only the POIs whose paths cross a newly inactive sensor and the POIs that had
+         *   fewer paths than required are re-routed (only if the set of inactive sensors changed at all). Greedy paths
+         *   depend on the whole level graph, so any change re-routes every POI, on the incrementally updated levels.
+         *   Kept exact paths are as many as a fresh search finds, but the votes of their sensors may differ
+         */
+        int fast_m_connectivity(int m, const SensorSet &inactive_sensors, std::unordered_map<int, int> *all_used_sensors,
+                                ConnectivityCertificate *certificate);
+        bool validate(bool raise, int k, int m, const SensorSet &inactive_sensors, ConnectivityCertificate *certificate);
+        int get_connectivity(int buffer[], const SensorSet &inactive_sensors, int target,
+                             ConnectivityCertificate *certificate);
+
+        /* Structured checks
+         * Same checks as fast_k_coverage and fast_m_connectivity, with structured results that hold at any scale
+         */
+        CheckResult check_k_coverage(int k, const SensorSet &inactive_sensors);
+        CheckResult check_k_coverage(int k, const SensorSet &inactive_sensors, SensorSet *all_used_sensors,
+                                     std::vector<int> *deficits);
+        CheckResult check_m_connectivity(int m, const SensorSet &inactive_sensors,
+                                         std::unordered_map<int, int> *all_used_sensors);
+        CheckResult check_m_connectivity(int m, const SensorSet &inactive_sensors,
+                                         std::unordered_map<int, int> *all_used_sensors,
+                                         ConnectivityCertificate *certificate);
+
+        /* Connectivity method used by fast_m_connectivity (thus validate) and get_connectivity: CONN_GREEDY paths, or
+         * CONN_EXACT max-flow. By default, from the environment variable KCMC_CONNECTIVITY ("exact" or greedy)
+         */
+        static int connectivity_method;
+
+        /* Number of threads evaluating the POIs of fast_m_connectivity and get_connectivity in parallel, with the
+         * same results as a serial run. By default, from the environment variable KCMC_THREADS (1 if not set,
+         * 0 for every hardware thread)
+         */
+        static int num_threads;
 
         /* Instance Preprocessors
          * Local Optima yelds ony the sensors required to validate the instance using Dinic's algorithm (limited)
@@ -187,23 +664,240 @@ class KCMC_Instance {
          *     minimal requirements until paths start to increase, so it has way more sensors.
          * Reuse uses the full-flood to get paths. Each path votes on all its composing sensors. Then, new paths are
          *   created preferring the most voted sensors in each dinic level.
+         * The best reuse (no flood level) keeps the smallest of the three reuse variants, run in parallel on up to
+         *   num_threads threads.
          */
         int local_optima(int k, int m, std::unordered_set<int> &inactive_sensors, std::unordered_set<int> *all_used_sensors);
-        int flood(int k, int m, bool full, std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
+        int local_optima(int k, int m, const SensorSet &inactive_sensors, std::unordered_set<int> *all_used_sensors);
+        long long flood(int k, int m, bool full, std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
         int reuse(int k, int m, int flood_level, std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
         int reuse(int k, int m, std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
+        long long flood(int k, int m, bool full, const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
+        int reuse(int k, int m, int flood_level, const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
+        int reuse(int k, int m, const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors);
+        long long flood(int k, int m, bool full, const SensorSet &inactive_sensors,
+                        std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace);
+        int reuse(int k, int m, int flood_level, const SensorSet &inactive_sensors,
+                  std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace);
+        int reuse(int k, int m, const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors,
+                  KCMC_Workspace &workspace);
+
+        /* Instance cache
+         * Key-only instances are regenerated from their seed. If a cache directory is set (by default, from the
+         * environment variable KCMC_CACHE_DIR), the regenerated adjacencies and base level graph are stored there,
+         * in files named after the hash of the instance key, and later loads of the same key map them instead.
+         */
+        static std::string cache_directory;
+        std::string cache_path(const std::string &extension) const;
 
         /* Other useful information about the instance
+         * The base level graph is the level graph with no inactive sensors, computed once for every instance
          */
+        std::vector<int> base_levels;
+        int base_max_level;
         int level_graph(int level_graph[], std::unordered_set<int> &inactive_sensors);
+        int level_graph(int level_graph[], const SensorSet &inactive_sensors);
         void get_placements(Placement *pl_pois, Placement *pl_sensors, Placement *pl_sinks);
 
     private:
+        /* Memory-mapped binary instance file the adjacencies are attached to, if loaded from one */
+        std::shared_ptr<MappedFile> mapping;
+
+        /* Generation buffers
+         * Node placements and spatial grids of every node type, kept so that regenerating the instance reuses them
+         */
+        std::vector<Placement> pl_pois, pl_sensors, pl_sinks;
+        UniformGrid coverage_grid, communication_grid, poi_grid, sink_grid;
+
+        /* Edge list buffers
+         * Poi-sensor, sensor-sensor (both directions) and sensor-sink edges collected while de-serializing the
+         * instance, before being compacted into the CSR adjacencies. Generated instances stream their rows instead
+         */
+        std::vector<std::pair<int, int>> ps_edges, ss_edges, sk_edges;
+
+        /* POI classes of the current graph. Empty until first used */
+        PoiClasses poi_class_storage;
+
+        /* Workspace of the preprocessors called without one */
+        KCMC_Workspace workspace;
+
+        /* Pool of connectivity buffers, leased by each connectivity evaluation */
+        std::vector<std::unique_ptr<ConnectivityScratch>> scratch_pool;
+        std::mutex scratch_lock;
+        std::unique_ptr<ConnectivityScratch> lease_scratch();
+        void return_scratch(std::unique_ptr<ConnectivityScratch> scratch);
+        void prepare_flow_networks(ConnectivityScratch &scratch, int threads, const SensorSet &inactive_sensors);
+        int prepare_blocks(ConnectivityScratch &scratch, int method, const SensorSet &inactive_sensors, int size);
+        int level_graph(int level_graph[], const SensorSet &inactive_sensors, ConnectivityScratch &scratch);
+        int poi_paths(ConnectivityScratch &scratch, int thread, int method, int a_poi, int limit,
+                      const SensorSet &inactive_sensors, const int level_graph[], std::vector<int> *used_sensors);
+        CheckResult m_connectivity_blocks(int m, int method, const SensorSet &inactive_sensors,
+                                          std::unordered_map<int, int> *all_used_sensors);
+        int connectivity_blocks(int buffer[], int method, const SensorSet &inactive_sensors, int target);
+        int certify(ConnectivityCertificate &certificate, int limit, const SensorSet &inactive_sensors, bool stop);
+
+        /* Preprocessor stages, shared with the heuristic session: the flood over a given level graph, and the reuse
+         * paths and k-coverage sensors over the votes of a flood (given in visited_sensors, replaced by the result)
+         */
+        long long flood_from_levels(int m, bool full, const SensorSet &inactive_sensors, const int level_graph[],
+                                    std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace);
+        int reuse_from_votes(int k, int m, long long num_paths, const SensorSet &inactive_sensors,
+                             std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace);
+        friend class HeuristicSession;
+
+        KCMC_Instance() = default;
         void get_placements(Placement *pl_pois, Placement *pl_sensors, Placement *pl_sinks, bool push);
         void regenerate();
-        int parse_edge(int stage, const std::string& token);
-        int find_path(int poi_number, std::unordered_set<int> &used_sensors,
-                      int level_graph[], int predecessors[]);
+        void attach_binary(std::shared_ptr<MappedFile> binary_file);
+        void compute_base_levels();
+        bool load_cached();
+        void store_cached();
+        void build_graph();
+        void drop_derived();
+        void parse(const char *first, const char *last);
+        int find_path(int poi_number, const SensorSet &used_sensors,
+                      const int level_graph[], SearchWorkspace &search);
+};
+
+
+/* COVERAGE STATE
+ * Incremental coverage of the POIs of an instance under a set of inactive sensors.
+ * Keeps the number of active sensors covering each POI, and the number of POIs covered by less than K of them.
+ * Toggling a single sensor updates only the POIs it covers, in O(degree). Syncing to another set of inactive
+ *   sensors toggles only the sensors in which both sets differ, so evaluating similar sets in sequence is cheap.
+ * The instance must outlive the state, and must not be reseeded while the state is in use.
+ */
+
+
+class CoverageState {
+    public:
+        CoverageState(const KCMC_Instance *instance, int k);
+
+        void reset(const SensorSet &inactive_sensors);
+        void sync(const SensorSet &inactive_sensors);
+        void activate(int sensor);
+        void deactivate(int sensor);
+        int coverage(int poi) const {return counts[poi];}
+        const int *coverage() const {return counts.data();}
+        int num_below_k() const {return below_k;}
+        int num_covered() const {return covered;}
+        bool k_covered() const {return below_k == 0;}
+        const SensorSet &inactive_sensors() const {return inactive;}
+
+    private:
+        const KCMC_Instance *instance;
+        int k, below_k, covered;
+        std::vector<int> counts;
+        SensorSet inactive;
+};
+
+
+/* LEVEL GRAPH
+ * Dynamic level graph of an instance: the same levels as KCMC_Instance::level_graph, kept from the hop distance of each
+ *   active sensor to the nearest sink, using only active sensors (unreachable and inactive sensors get level
+ *   num_sensors).
+ * It can be fully rebuilt over flat arrays, or updated when a single sensor is activated or deactivated, touching
+ *   only the sensors whose distance changes (and, on deactivation, their neighbors), then the levels around them.
+ * The instance must outlive the level graph, and must not be reseeded while the level graph is in use.
+ */
+
+
+class LevelGraph {
+    public:
+        explicit LevelGraph(const KCMC_Instance *instance);
+
+        void rebuild(const SensorSet &inactive_sensors);
+        void sync(const SensorSet &inactive_sensors);
+        void activate(int sensor);
+        void deactivate(int sensor);
+        int operator[](int sensor) const {return level[sensor];}
+        const int *levels() const {return level.data();}
+        int max_level() const;
+        const SensorSet &inactive_sensors() const {return inactive;}
+
+    private:
+        const KCMC_Instance *instance;
+        std::vector<int> distance, level, work_queue, orphan_level;
+        SensorSet inactive;
+        int level_of(int sensor) const;
+        void refresh_levels();
+};
+
+
+/* HEURISTIC SESSION
+ * The preprocessors of an instance for a fixed K, M and set of inactive sensors, sharing their intermediate results.
+ * The level graph (after the K-coverage check), the votes of the no-flood, min-flood and max-flood paths, and the
+ *   result of each reuse variation are computed on first use and kept. So the dinic local optima and the no-flood
+ *   reuse share the same paths, each reuse starts from the votes of its flood, and the best reuse only compares them.
+ * Same results as the preprocessors of the instance. The instance must outlive the session, and must not be reseeded
+ *   while the session is in use.
+ * The stages of different variations may run concurrently (e.g. the flood and reuse of each variation in its own
+ *   task), as each variation has its own workspace and the shared level graph is computed under a lock. prepare()
+ *   computes it (after the K-coverage check) up front, so that concurrent stages never wait for each other. The best
+ *   reuse must only run after the three reuse variations are done.
+ */
+
+
+class HeuristicSession {
+    public:
+        HeuristicSession(KCMC_Instance *instance, int k, int m, const SensorSet &inactive_sensors);
+
+        void prepare();
+        int local_optima(std::unordered_set<int> *result_buffer);
+        long long flood(bool full, std::unordered_map<int, int> *visited_sensors);
+        int reuse(int flood_level, std::unordered_map<int, int> *visited_sensors);
+        int reuse(std::unordered_map<int, int> *visited_sensors);
+
+    private:
+        /* Votes of the paths of each variation (max-flood, no-flood, min-flood), and the reuse over them */
+        struct Votes {
+            bool done = false, connected = true;
+            long long num_paths = 0;
+            std::unordered_map<int, int> votes;
+        };
+        struct Reuse {
+            bool done = false;
+            int added = 0, used = 0;
+            std::unordered_map<int, int> visited;
+        };
+
+        KCMC_Instance *instance;
+        int k, m;
+        SensorSet inactive;
+        std::vector<int> levels;
+        std::mutex levels_lock;
+        Votes variant_votes[3];
+        Reuse variant_reuse[3];
+        KCMC_Workspace workspaces[3];
+
+        const int *level_graph();
+        const Votes &votes(int variant);
+        const Reuse &reuse_variant(int variant);
+};
+
+
+/* CONNECTIVITY CERTIFICATE
+ * Disjoint paths found for each POI class of an instance under a set of inactive sensors: the number of paths (up to
+ *   the limit they were searched with, or -1 if not evaluated yet) and the sensors they cross. Each sensor also lists
+ *   the classes whose paths cross it, so deactivating a sensor invalidates only those classes.
+ * Exact paths stay valid while none of their sensors is deactivated, so a class with as many as the limit keeps them.
+ *   A fresh greedy search may find fewer paths than the intact ones, so with greedy paths every class is re-routed on
+ *   any change, and only the level graph is updated incrementally. Either way, the certified connectivity is the
+ *   same as a fresh evaluation.
+ * Produced and consumed by the certified connectivity services of the instance. The instance must outlive the
+ *   certificate, and must not be reseeded while the certificate is in use.
+ */
+
+
+struct ConnectivityCertificate {
+    int method = -1, limit = 0;
+    SensorSet inactive;
+    std::vector<int> paths;
+    std::vector<std::vector<int>> used, users;
+    std::unique_ptr<LevelGraph> level_graph;
+
+    bool empty() const {return paths.empty();}
+    void clear() {method = -1; limit = 0; paths.clear(); used.clear(); users.clear(); level_graph.reset();}
 };
 
 #endif
@@ -0,0 +1,252 @@
+/** LEVEL_GRAPH.cpp
+ * Implementation of the dynamic level graph, kept up to date as single sensors are activated or deactivated
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::fill, std::min
+#include <queue>      // priority_queue
+#include <utility>    // pair
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* #####################################################################################################################
+ * FULL REBUILD
+ */
+
+/** Level graph constructor
+ * Starts with every sensor of the instance active
+ */
+LevelGraph::LevelGraph(const KCMC_Instance *instance) : instance(instance) {
+    this->rebuild(SensorSet(instance->num_sensors));
+}
+
+
+/** LEVEL GRAPH REBUILD
+ * Breadth-first search from the sensors that communicate with any sink, over flat arrays reused by every rebuild
+ */
+void LevelGraph::rebuild(const SensorSet &inactive_sensors) {
+    int head, node, unreachable = this->instance->num_sensors;
+
+    // Copy the inactive sensors
+    inactive_sensors.require_width(this->instance->num_sensors);
+    this->inactive = inactive_sensors;
+
+    // The sink neighbors are at level 0, and every other sensor is unreachable until visited
+    this->distance.assign(this->instance->num_sensors, unreachable);
+    this->work_queue.clear();
+    for (node=0; node < this->instance->num_sensors; node++) {
+        if ((not this->inactive.contains(node)) and (not this->instance->sensor_sink[node].empty())) {
+            this->distance[node] = 0;
+            this->work_queue.push_back(node);
+        }
+    }
+    for (head=0; head < (int)this->work_queue.size(); head++) {
+        node = this->work_queue[head];
+        for (const int &neighbor : this->instance->sensor_sensor[node]) {
+            if ((this->distance[neighbor] == unreachable) and (not this->inactive.contains(neighbor))) {
+                this->distance[neighbor] = this->distance[node] + 1;
+                this->work_queue.push_back(neighbor);
+            }
+        }
+    }
+
+    // Levels of the reached sensors, in increasing distance order
+    this->level.assign(this->instance->num_sensors, unreachable);
+    for (const int &reached : this->work_queue) {this->level[reached] = this->level_of(reached);}
+}
+
+
+/** MAX LEVEL
+ * Same value returned by KCMC_Instance::level_graph: the number of BFS rounds, one more than the highest finite level
+ */
+int LevelGraph::max_level() const {
+    int highest = -1;
+    for (const int &a_level : this->level) {
+        if ((a_level < this->instance->num_sensors) and (a_level > highest)) {highest = a_level;}
+    }
+    return highest + 1;
+}
+
+
+/* #####################################################################################################################
+ * LEVELS
+ */
+
+/** Level of a reached sensor
+ * As in KCMC_Instance::level_graph, its distance, plus one (past distance 0) if it has an active neighbor at the same
+ * distance, or a neighbor one hop closer that got the extra level itself. The levels of the closer sensors must be up
+ * to date
+ */
+int LevelGraph::level_of(const int sensor) const {
+    if (this->distance[sensor] == 0) {return 0;}
+    for (const int &neighbor : this->instance->sensor_sensor[sensor]) {
+        if ((this->distance[neighbor] == this->distance[sensor])
+            or ((this->distance[neighbor] == this->distance[sensor] - 1) and (this->level[neighbor] == this->distance[sensor]))) {
+            return this->distance[sensor] + 1;
+        }
+    }
+    return this->distance[sensor];
+}
+
+
+/** Level refresh
+ * After an update, revisits the sensors whose distance changed (left in the work queue) and their neighbors, in
+ * increasing distance order. A sensor whose level changes also revisits its neighbors one hop farther
+ */
+void LevelGraph::refresh_levels() {
+    int node, new_level, unreachable = this->instance->num_sensors;
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+    auto revisit = [&](const int a_sensor) {
+        if (this->distance[a_sensor] < unreachable) {queue.push({this->distance[a_sensor], a_sensor});}
+        else {this->level[a_sensor] = unreachable;}
+    };
+    for (const int &changed : this->work_queue) {
+        revisit(changed);
+        for (const int &neighbor : this->instance->sensor_sensor[changed]) {revisit(neighbor);}
+    }
+
+    while (not queue.empty()) {
+        node = queue.top().second;
+        queue.pop();
+        new_level = this->level_of(node);
+        if (new_level == this->level[node]) {continue;}
+        this->level[node] = new_level;
+        for (const int &neighbor : this->instance->sensor_sensor[node]) {
+            if (this->distance[neighbor] == this->distance[node] + 1) {queue.push({this->distance[neighbor], neighbor});}
+        }
+    }
+}
+
+
+/* #####################################################################################################################
+ * INCREMENTAL UPDATES
+ */
+
+/** Sensor activation
+ * The activated sensor gets one level more than its best active neighbor (or 0 if it communicates with a sink), and
+ * the decrease is propagated breadth-first only to the sensors it gets closer to the sinks
+ */
+void LevelGraph::activate(const int sensor) {
+    int head, node, unreachable = this->instance->num_sensors;
+    if (not this->inactive.contains(sensor)) {return;}
+    this->inactive.erase(sensor);
+
+    // Level of the activated sensor
+    if (not this->instance->sensor_sink[sensor].empty()) {this->distance[sensor] = 0;}
+    else {
+        for (const int &neighbor : this->instance->sensor_sensor[sensor]) {
+            if (this->distance[neighbor] < unreachable) {
+                this->distance[sensor] = std::min(this->distance[sensor], this->distance[neighbor] + 1);
+            }
+        }
+    }
+    if (this->distance[sensor] == unreachable) {return;}
+
+    // Propagate the improvement
+    this->work_queue.clear();
+    this->work_queue.push_back(sensor);
+    for (head=0; head < (int)this->work_queue.size(); head++) {
+        node = this->work_queue[head];
+        for (const int &neighbor : this->instance->sensor_sensor[node]) {
+            if ((not this->inactive.contains(neighbor)) and (this->distance[neighbor] > this->distance[node] + 1)) {
+                this->distance[neighbor] = this->distance[node] + 1;
+                this->work_queue.push_back(neighbor);
+            }
+        }
+    }
+    this->refresh_levels();
+}
+
+
+/** Sensor deactivation
+ * First, finds the orphans: the sensors whose every shortest path to a sink crosses the deactivated sensor. They are
+ *   found level by level from the deactivated sensor, as the sensors with no non-orphan active neighbor one level
+ *   closer to the sinks. Sensors that communicate with a sink are never orphans.
+ * Then, each orphan gets one level more than its best non-orphan neighbor, and the orphans are settled in increasing
+ *   level order (Dijkstra with unit weights), as only they may have changed
+ */
+void LevelGraph::deactivate(const int sensor) {
+    int head, node, unreachable = this->instance->num_sensors;
+    bool has_parent;
+    if (this->inactive.contains(sensor)) {return;}
+    this->inactive.insert(sensor);
+    if (this->distance[sensor] == unreachable) {return;}
+
+    // Find the orphans, marking them as unreachable. The deactivated sensor is the first one
+    this->work_queue.clear();
+    this->work_queue.push_back(sensor);
+    this->orphan_level.assign(1, this->distance[sensor]);
+    this->distance[sensor] = unreachable;
+    for (head=0; head < (int)this->work_queue.size(); head++) {
+        node = this->work_queue[head];
+        for (const int &child : this->instance->sensor_sensor[node]) {
+            if (this->inactive.contains(child) or (this->distance[child] != this->orphan_level[head] + 1)) {continue;}
+            has_parent = false;
+            for (const int &parent : this->instance->sensor_sensor[child]) {
+                if ((not this->inactive.contains(parent)) and (this->distance[parent] == this->distance[child] - 1)) {
+                    has_parent = true;
+                    break;
+                }
+            }
+            if (not has_parent) {
+                this->work_queue.push_back(child);
+                this->orphan_level.push_back(this->distance[child]);
+                this->distance[child] = unreachable;
+            }
+        }
+    }
+
+    // Tentative levels of the orphans, from their non-orphan neighbors
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+    for (head=1; head < (int)this->work_queue.size(); head++) {
+        node = this->work_queue[head];
+        for (const int &neighbor : this->instance->sensor_sensor[node]) {
+            if ((not this->inactive.contains(neighbor)) and (this->distance[neighbor] + 1 < this->distance[node])) {
+                this->distance[node] = this->distance[neighbor] + 1;
+            }
+        }
+        if (this->distance[node] < unreachable) {queue.push({this->distance[node], node});}
+    }
+
+    // Settle the orphans in increasing level order
+    while (not queue.empty()) {
+        int queued_level = queue.top().first;
+        node = queue.top().second;
+        queue.pop();
+        if (queued_level != this->distance[node]) {continue;}  // Stale entry
+        for (const int &neighbor : this->instance->sensor_sensor[node]) {
+            if ((not this->inactive.contains(neighbor)) and (this->distance[neighbor] > this->distance[node] + 1)) {
+                this->distance[neighbor] = this->distance[node] + 1;
+                queue.push({this->distance[neighbor], neighbor});
+            }
+        }
+    }
+    this->refresh_levels();
+}
+
+
+/** Level graph sync
+ * Toggles each sensor whose state differs from the given set of inactive sensors, or rebuilds the whole level graph
+ * if more than a sixteenth of the sensors differ
+ */
+void LevelGraph::sync(const SensorSet &inactive_sensors) {
+    int a_sensor, differences = 0;
+    inactive_sensors.require_width(this->instance->num_sensors);
+    for (a_sensor=0; a_sensor < this->instance->num_sensors; a_sensor++) {
+        if (this->inactive.contains(a_sensor) != inactive_sensors.contains(a_sensor)) {
+            differences++;
+        }
+    }
+    if (differences * 16 > this->instance->num_sensors) {
+        this->rebuild(inactive_sensors);
+        return;
+    }
+    for (a_sensor=0; a_sensor < this->instance->num_sensors; a_sensor++) {
+        if (inactive_sensors.contains(a_sensor)) {this->deactivate(a_sensor);}
+        else {this->activate(a_sensor);}
+    }
+}
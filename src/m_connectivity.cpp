@@ -2,7 +2,8 @@
 
 // STDLib dependencies
 #include <sstream>    // ostringstream
-#include <queue>      // priority_queue
+#include <algorithm>  // copy, fill, min, max, push_heap, pop_heap
+#include <atomic>     // atomic
 
 // Dependencies from this package
 #include "kcmc_instance.h"  // KCMC Instance class headers
@@ -12,26 +13,51 @@
  * Sets in each active sensor its level, that is the lowest distance to a sink using only active sensors
  */
 int KCMC_Instance::level_graph(int level_graph[], std::unordered_set<int> &inactive_sensors) {
-    /* Sets the lowest distance in hops from each active sensor to the nearest sink using only active sensors
+    return this->level_graph(level_graph, SensorSet(this->num_sensors, inactive_sensors));
+}
+int KCMC_Instance::level_graph(int level_graph[], const SensorSet &inactive_sensors) {
+    std::unique_ptr<ConnectivityScratch> scratch = this->lease_scratch();
+    int max_level = this->level_graph(level_graph, inactive_sensors, *scratch);
+    this->return_scratch(std::move(scratch));
+    return max_level;
+}
+int KCMC_Instance::level_graph(int level_graph[], const SensorSet &inactive_sensors, ConnectivityScratch &scratch) {
+    /* Sets the lowest distance in hops from each active sensor to the nearest sink using only active sensors.
+     * Sensors that cannot reach a sink (and inactive sensors) get level num_sensors, worse than any reachable sensor.
+     * Past level 0, a work set is only marked as visited after the next one is found, so a sensor with a neighbor in its
+     *   own work set (or in the previous one, if that neighbor got there this way) is also in the next work set, and
+     *   ends one level higher
      */
+    inactive_sensors.require_width(this->num_sensors);
 
-    // Reused buffers
-    int level = 0;
-    std::unordered_set<int> visited, work_set, next_set;
+    // If every sensor is active, copy the base level graph of the instance
+    if ((not this->base_levels.empty()) and inactive_sensors.empty()) {
+        std::copy(this->base_levels.begin(), this->base_levels.end(), level_graph);
+        return this->base_max_level;
+    }
 
-    // Get the set of active neighbors of sinks. Set each neighbor's level to 0
-    for (const auto &a_sink : this->sink_sensor) {
-       for (const int &neighbor : a_sink.second) {
-           if (not isin(inactive_sensors, neighbor)) {
+    // Buffers of the scratch. The round of each sensor is the last level it was put in a work set at
+    int level = 0;
+    SensorSet &visited = scratch.visited;
+    std::vector<int> &work_set = scratch.work_set, &next_set = scratch.next_set, &round = scratch.level_round;
+    round.assign(this->num_sensors, -1);
+    work_set.clear();
+    std::fill(level_graph, level_graph + this->num_sensors, this->num_sensors);
+
+    // Mark all inactive sensors as visited
+    visited = inactive_sensors;
+
+    // Get the set of active neighbors of sinks. Set each neighbor's level to 0 and mark it as visited
+    for (int a_sink=0; a_sink < this->num_sinks; a_sink++) {
+       for (const int &neighbor : this->sink_sensor[a_sink]) {
+           if (not visited.contains(neighbor)) {
                level_graph[neighbor] = 0;
-               work_set.insert(neighbor);
+               visited.insert(neighbor);
+               work_set.push_back(neighbor);
            }
        }
     }
 
-    // Mark all sensors in the set as visited, as well as the inactive sensors
-    visited = set_merge(inactive_sensors, work_set);
-
     // While there are still sensors to visit, find and visit them and set their level
     while (!work_set.empty()) {
         // advance the level
@@ -41,16 +67,17 @@ int KCMC_Instance::level_graph(int level_graph[], std::unordered_set<int> &inact
         next_set.clear();
         for (const int &source : work_set) {
             for (const int &neighbor : this->sensor_sensor[source]) {
-                if (not isin(visited, neighbor)) {
-                    next_set.insert(neighbor);
+                if ((not visited.contains(neighbor)) and (round[neighbor] != level)) {
+                    next_set.push_back(neighbor);
+                    round[neighbor] = level;
                     level_graph[neighbor] = level;
                 }
             }
         }
 
         // Mark the work set as visited and swap it to the next set
-        visited = set_merge(visited, work_set);
-        work_set = next_set;
+        for (const int &source : work_set) {visited.insert(source);}
+        work_set.swap(next_set);
     }
 
     // Return the max level found
@@ -58,29 +85,94 @@ int KCMC_Instance::level_graph(int level_graph[], std::unordered_set<int> &inact
 }
 
 
+/** BASE LEVEL-GRAPH
+ * Computes (and keeps in the instance) the level graph with every sensor active, which is reused by every
+ * level graph requested with an empty set of inactive sensors
+ */
+void KCMC_Instance::compute_base_levels() {
+    SensorSet emptyset(this->num_sensors);
+    std::vector<int> levels(this->num_sensors);
+    this->base_levels.clear();  // Must be empty while computing, or the level graph would copy it
+    this->base_max_level = this->level_graph(levels.data(), emptyset);
+    this->base_levels.swap(levels);
+}
+
+
+/** BUCKET QUEUE
+ * Keys below or above the window go to the heaps, as it only moves when the queue is empty
+ */
+void BucketQueue::clear() {
+    for (; (in_buckets > 0) and (lowest < WINDOW); lowest++) {
+        in_buckets -= (int)buckets[lowest].size();
+        buckets[lowest].clear();
+    }
+    lowest = WINDOW;
+    in_buckets = 0;
+    below.clear();
+    above.clear();
+}
+
+void BucketQueue::push(const int index, const int key) {
+    if (this->empty()) {offset = (int)std::max((long long)key - (3 * WINDOW / 4), (long long)INT32_MIN);}
+    long long slot = (long long)key - offset;
+    if (slot < 0) {
+        below.push_back({index, key});
+        std::push_heap(below.begin(), below.end(), CompareLevelNode());
+    } else if (slot >= WINDOW) {
+        above.push_back({index, key});
+        std::push_heap(above.begin(), above.end(), CompareLevelNode());
+    } else {
+        buckets[slot].push_back(index);
+        std::push_heap(buckets[slot].begin(), buckets[slot].end());
+        in_buckets++;
+        if (slot < lowest) {lowest = (int)slot;}
+    }
+}
+
+int BucketQueue::pop() {
+    int index;
+    std::vector<LevelNode> *heap = &above;
+    if (not below.empty()) {heap = &below;}
+    else if (in_buckets > 0) {
+        while (buckets[lowest].empty()) {lowest++;}
+        std::vector<int> &bucket = buckets[lowest];
+        std::pop_heap(bucket.begin(), bucket.end());
+        index = bucket.back();
+        bucket.pop_back();
+        in_buckets--;
+        return index;
+    }
+    index = heap->front().index;
+    std::pop_heap(heap->begin(), heap->end(), CompareLevelNode());
+    heap->pop_back();
+    return index;
+}
+
+
 /** A* (A-STAR) PATHFINDING ALGORITHM
+ * The predecessors of the found path are left in the search workspace: -1 for the sensor covering the POI
  */
-int KCMC_Instance::find_path(const int poi_number, std::unordered_set<int> &used_sensors,
-                             int level_graph[], int predecessors[]) {
+int KCMC_Instance::find_path(const int poi_number, const SensorSet &used_sensors,
+                             const int level_graph[], SearchWorkspace &search) {
 
-    // Local buffers
+    // Local buffers. The priority queue is a bucket queue over the storage of the workspace
     int i_sensor;
-    std::priority_queue<LevelNode, std::vector<LevelNode>, CompareLevelNode> queue;
+    BucketQueue &queue = search.queue;
+    search.start(this->num_sensors);
 
     // Prepare a queue with each active unused sensor that covers the POI
     // Add each of those sensors to the predecessors map having "-1" as the predecessor, meaning "the POI is the predecessor"
     for (const int &a_sensor : this->poi_sensor[poi_number]) {
-        if (not isin(used_sensors, a_sensor)) {
-            queue.push({a_sensor, level_graph[a_sensor]});
-            predecessors[a_sensor] = -1;
+        if (not used_sensors.contains(a_sensor)) {
+            queue.push(a_sensor, level_graph[a_sensor]);
+            search.visit(a_sensor, -1);
         }
     }
 
     // Iterate until the queue is empty
     while (not queue.empty()) {
         // Get the top sensor in the queue (lowest level) and visit it
-        i_sensor = queue.top().index;
-        queue.pop();
+        i_sensor = queue.pop();
 
         // If the sensor is neighbor of a sink, return the sensor as the beginning of the path
         if (isin(this->sensor_sink, i_sensor)) {return i_sensor;}
@@ -88,9 +180,9 @@ int KCMC_Instance::find_path(const int poi_number, std::unordered_set<int> &used
         // For each neighbor of the top sensor, if the neighbor has not been used or visited yet,
         // Add the unvisited active neighbor to the queue and the top sensor as its predecessor
         for (const int &neighbor : this->sensor_sensor[i_sensor]) {
-            if ((not isin(used_sensors, neighbor)) and (predecessors[neighbor] == -2)){
-                queue.push({neighbor, level_graph[neighbor]});
-                predecessors[neighbor] = i_sensor;
+            if ((not used_sensors.contains(neighbor)) and (not search.visited(neighbor))){
+                queue.push(neighbor, level_graph[neighbor]);
+                search.visit(neighbor, i_sensor);
                 // If the neighbor is sink-adjacent, we can return it directly
                 if (isin(this->sensor_sink, neighbor)) {return neighbor;}
             }
@@ -102,6 +194,75 @@ int KCMC_Instance::find_path(const int poi_number, std::unordered_set<int> &used
 }
 
 
+/** PATHS OF A POI
+ * Finds up to limit node-disjoint paths from the POI to any sink, using either the greedy path finder (over the given
+ * level graph) or the exact flow network of the thread. The sensors in the paths are appended to used_sensors, in
+ * the order the paths are unraveled. Each thread has its own scratch buffers, so many POIs can run at once.
+ */
+int KCMC_Instance::poi_paths(ConnectivityScratch &buffers, const int thread, const int method, const int a_poi,
+                             const int limit, const SensorSet &inactive_sensors, const int level_graph[],
+                             std::vector<int> *used_sensors) {
+    if (method == CONN_EXACT) {return buffers.flows[thread].max_paths(this->poi_sensor[a_poi], limit, used_sensors);}
+
+    // Create a loop control flag and pointer buffers
+    PathScratch &scratch = buffers.paths[thread];
+    int paths_found = 0, path_end;
+    scratch.used_sensors = inactive_sensors;  // Reset the set of used sensors for each POI
+
+    // While there are still paths to be found
+    while (paths_found < limit) {
+        // Find a path. If the path ends in an invalid sensor, there are no more paths
+        path_end = this->find_path(a_poi, scratch.used_sensors, level_graph, scratch.search);
+        if (path_end == -1) {break;}
+
+        // If success, count the path and mark all the sensors with predecessors as "used"
+        paths_found += 1;
+        while (path_end != -1) {
+            scratch.used_sensors.insert(path_end);
+            if (used_sensors != nullptr) {used_sensors->push_back(path_end);}
+            path_end = scratch.search.predecessor(path_end);
+            if (path_end == -2) {throw std::runtime_error("FORBIDDEN ADDRESS!");}
+        }
+    }
+    return paths_found;
+}
+
+
+/** CONNECTIVITY SCRATCH POOL
+ * Leases a free set of connectivity buffers (a new one if none is free), and returns it to the pool. A set that is not
+ * returned (i.e. after an exception) is simply freed
+ */
+std::unique_ptr<ConnectivityScratch> KCMC_Instance::lease_scratch() {
+    std::lock_guard<std::mutex> guard(this->scratch_lock);
+    if (this->scratch_pool.empty()) {return std::unique_ptr<ConnectivityScratch>(new ConnectivityScratch());}
+    std::unique_ptr<ConnectivityScratch> scratch = std::move(this->scratch_pool.back());
+    this->scratch_pool.pop_back();
+    return scratch;
+}
+
+void KCMC_Instance::return_scratch(std::unique_ptr<ConnectivityScratch> scratch) {
+    std::lock_guard<std::mutex> guard(this->scratch_lock);
+    this->scratch_pool.push_back(std::move(scratch));
+}
+
+
+/** PER-CLASS BLOCKS
+ * Prepares the shared level graph (greedy) or the flow networks (exact) and the scratch of each thread, for splitting
+ * size POI classes in contiguous blocks, one per thread. Returns the number of threads
+ */
+int KCMC_Instance::prepare_blocks(ConnectivityScratch &scratch, const int method, const SensorSet &inactive_sensors,
+                                  const int size) {
+    int threads = std::max(1, std::min(num_threads, size));
+    if ((int)scratch.paths.size() < threads) {scratch.paths.resize(threads);}
+    if (method == CONN_EXACT) {this->prepare_flow_networks(scratch, threads, inactive_sensors);}
+    else {
+        scratch.levels.resize(this->num_sensors);
+        this->level_graph(scratch.levels.data(), inactive_sensors, scratch);
+    }
+    return threads;
+}
+
+
 /** FAST M-CONNECTIVITY VALIDATOR USING DINIC'S ALGORITHM
  * Fastest validator.
  * It could also validate if every POI has at least M connections to sensors,
@@ -111,84 +272,144 @@ int KCMC_Instance::find_path(const int poi_number, std::unordered_set<int> &used
  */
 int KCMC_Instance::fast_m_connectivity(const int m, std::unordered_set<int> &inactive_sensors,
                                        std::unordered_map<int, int> *all_used_sensors) {
+    return this->fast_m_connectivity(m, SensorSet(this->num_sensors, inactive_sensors), all_used_sensors);
+}
+int KCMC_Instance::fast_m_connectivity(const int m, const SensorSet &inactive_sensors,
+                                       std::unordered_map<int, int> *all_used_sensors) {
     /** Verify if every POI has at least M different disjoint paths to all SINKs
      */
-     int total_paths_found = 0;
-    // Clear the set of active sensors
+    CheckResult result = this->check_m_connectivity(m, inactive_sensors, all_used_sensors);
+    if (not result.ok()) {return ((1+result.failing_poi)*1000000)+result.found;}  // Encoded the two ints. We must not have more than a Million POIs!
+    return (int)(result.total_paths);
+}
+CheckResult KCMC_Instance::check_m_connectivity(const int m, const SensorSet &inactive_sensors,
+                                                std::unordered_map<int, int> *all_used_sensors) {
+    return this->m_connectivity_blocks(m, connectivity_method, inactive_sensors, all_used_sensors);
+}
+int KCMC_Instance::fast_m_connectivity(const int m, std::unordered_set<int> &inactive_sensors,
+                                       std::unordered_set<int> *all_used_sensors) {
+    return this->fast_m_connectivity(m, SensorSet(this->num_sensors, inactive_sensors), all_used_sensors);
+}
+int KCMC_Instance::fast_m_connectivity(const int m, const SensorSet &inactive_sensors,
+                                       std::unordered_set<int> *all_used_sensors) {
+    // Run with a map
+    std::unordered_map<int, int> buffer;
+    CheckResult result = this->check_m_connectivity(m, inactive_sensors, &buffer);
+    // Revert back to set
     all_used_sensors->clear();
+    for (const auto i : buffer) {all_used_sensors->insert(i.first);}
+    return result.ok() ? -1 : ((1+result.failing_poi)*1000000)+result.found;  // Encoded the two ints
+}
 
-    // Base case
-    if (m < 1){return -1;}
 
-    // Create the level graph
-    int level_graph[this->num_sensors];
-    this->level_graph(level_graph, inactive_sensors);
+/** M-CONNECTIVITY OF EVERY POI, IN PARALLEL BLOCKS
+ * Only the representative of each POI class is evaluated, as every POI of a class has the same paths. Each thread
+ * runs its block of classes in order, stopping at its first failure, or as soon as a failure is known at a lower
+ * class. The POIs are then aggregated in order, each voting the used sensors of its class, so the results (first
+ * failing POI, total paths and votes) are the same as a serial run over every POI, whatever the number of threads.
+ */
+CheckResult KCMC_Instance::m_connectivity_blocks(const int m, const int method, const SensorSet &inactive_sensors,
+                                                 std::unordered_map<int, int> *all_used_sensors) {
+    CheckResult result;
+    inactive_sensors.require_width(this->num_sensors);
 
-    // Prepare the set of "used" sensors
-    std::unordered_set<int> used_sensors;
+    // Clear the set of active sensors
+    all_used_sensors->clear();
 
-    // Create a loop control flag and pointer buffers
-    int paths_found, path_end, a_poi, predecessors[this->num_sensors];
-
-    // Run for each POI, returning at the first failure
-    for (a_poi=0; a_poi < this->num_pois; a_poi++) {
-        paths_found = 0;  // Clear the number of paths found for the POI
-        used_sensors = inactive_sensors;  // Reset the set of used sensors for each POI
-
-        // While there are still paths to be found
-        while (paths_found < m) {
-            std::fill(predecessors, predecessors+this->num_sensors, -2);  // Reset the predecessors buffer
-
-            // Find a path
-            path_end = this->find_path(a_poi, used_sensors, level_graph, predecessors);
-
-            // If the path ends in an invalid sensor, return the failure.
-            if (path_end == -1) {
-                return ((1+a_poi)*1000000)+paths_found;  // Encoded the two ints. We must not have more than a Million POIs!
-
-            // If success, count the path and mark all the sensors with predecessors as "used"
-            } else {
-                paths_found += 1;  // Count the newfound path
-                total_paths_found += 1;
-                // Unravel the path, marking each sensor in it as used
-                while (path_end != -1) {
-                    used_sensors.insert(path_end);
-                    vote(*all_used_sensors, path_end);  // Get the complete list of all used sensors
-                    path_end = predecessors[path_end];
-                    if (path_end == -2) {throw std::runtime_error("FORBIDDEN ADDRESS!");}
-                }
+    // Base case
+    if (m < 1){return result;}
+
+    // Prepare the shared and the per-thread buffers, and the results of each class
+    const PoiClasses &classes = this->poi_classes();
+    std::unique_ptr<ConnectivityScratch> scratch = this->lease_scratch();
+    int threads = this->prepare_blocks(*scratch, method, inactive_sensors, classes.size());
+    std::vector<int> &class_paths = scratch->class_paths, &class_thread = scratch->class_thread,
+                     &used_begin = scratch->used_begin, &used_end = scratch->used_end;
+    std::vector<std::vector<int>> &block_used = scratch->block_used;
+    class_paths.assign(classes.size(), -1);
+    class_thread.resize(classes.size());
+    used_begin.resize(classes.size());
+    used_end.resize(classes.size());
+    if ((int)block_used.size() < threads) {block_used.resize(threads);}
+    for (std::vector<int> &used : block_used) {used.clear();}
+    std::atomic<int> failing_class(classes.size());
+
+    run_parallel(classes.size(), threads, [&](const int thread, const int begin, const int end) {
+        int a_class, known_failure;
+        for (a_class=begin; a_class<end; a_class++) {
+            if (a_class > failing_class.load(std::memory_order_relaxed)) {break;}
+            class_thread[a_class] = thread;
+            used_begin[a_class] = (int)block_used[thread].size();
+            class_paths[a_class] = this->poi_paths(*scratch, thread, method, classes.representative[a_class], m,
+                                                   inactive_sensors, scratch->levels.data(), &block_used[thread]);
+            used_end[a_class] = (int)block_used[thread].size();
+            if (class_paths[a_class] < m) {
+                known_failure = failing_class.load();
+                while ((a_class < known_failure) and (not failing_class.compare_exchange_weak(known_failure, a_class))) {}
+                break;
             }
         }
+    });
+
+    // Aggregate the POIs in order, stopping at the first failure. Every class up to the first failing one was run
+    int a_class;
+    for (int a_poi=0; a_poi < this->num_pois; a_poi++) {
+        a_class = classes.of_poi[a_poi];
+        const std::vector<int> &used = block_used[class_thread[a_class]];
+        for (int i=used_begin[a_class]; i<used_end[a_class]; i++) {vote(*all_used_sensors, used[i]);}  // Get the complete list of all used sensors
+        if (class_paths[a_class] < m) {
+            result.failing_poi = a_poi;
+            result.found = class_paths[a_class];
+            break;
+        }
+        result.total_paths += class_paths[a_class];
     }
+    this->return_scratch(std::move(scratch));
 
-    // Success in each and every POI!
-    return total_paths_found;
-}
-int KCMC_Instance::fast_m_connectivity(const int m, std::unordered_set<int> &inactive_sensors,
-                                       std::unordered_set<int> *all_used_sensors) {
-    // Run with a map
-    std::unordered_map<int, int> buffer;
-    int result = this->fast_m_connectivity(m, inactive_sensors, &buffer);
-    // adjust the result
-    if (result < 1000000) {result = -1;}  // WE MUST HAVE FEWER THAN A MILLION PATHS!
-    // Revert back to set
-    all_used_sensors->clear();
-    for (const auto i : buffer) {all_used_sensors->insert(i.first);}
+    // The first failure, or success in each and every POI!
     return result;
 }
 
 
+/** CONNECTIVITY OF EVERY POI, IN PARALLEL BLOCKS
+ * Only the representative of each POI class is evaluated, and its connectivity is then copied to the whole class.
+ * Each POI has its own position in the buffer, so the blocks need no synchronization
+ */
+int KCMC_Instance::connectivity_blocks(int buffer[], const int method, const SensorSet &inactive_sensors, const int target) {
+    inactive_sensors.require_width(this->num_sensors);
+    const PoiClasses &classes = this->poi_classes();
+    std::unique_ptr<ConnectivityScratch> scratch = this->lease_scratch();
+    int threads = this->prepare_blocks(*scratch, method, inactive_sensors, classes.size());
+
+    run_parallel(classes.size(), threads, [&](const int thread, const int begin, const int end) {
+        for (int a_class=begin; a_class<end; a_class++) {
+            const int &a_poi = classes.representative[a_class];
+            buffer[a_poi] = this->poi_paths(*scratch, thread, method, a_poi, target, inactive_sensors,
+                                            scratch->levels.data(), nullptr);
+        }
+    });
+    this->return_scratch(std::move(scratch));
+
+    // Return the number of POIs under the target
+    int has_connection = 0;
+    for (int a_poi=0; a_poi < this->num_pois; a_poi++) {
+        buffer[a_poi] = buffer[classes.representative[classes.of_poi[a_poi]]];
+        if (buffer[a_poi] < target) {has_connection += 1;}
+    }
+    return has_connection;
+}
+
+
 /** M-CONNECTIVITY VALIDATOR USING DINIC'S ALGORITHM
  * Wrapper around the fastest validator, to allow for better process message passing.
  */
 std::string KCMC_Instance::m_connectivity(const int m, std::unordered_set<int> &inactive_sensors) {
-    std::unordered_set<int> used_sensors;
-    int failure_at = this->fast_m_connectivity(m, inactive_sensors, &used_sensors);
-    if (failure_at == -1) {return "SUCCESS";}
+    std::unordered_map<int, int> used_sensors;
+    CheckResult result = this->check_m_connectivity(m, SensorSet(this->num_sensors, inactive_sensors), &used_sensors);
+    if (result.ok()) {return "SUCCESS";}
     else {
         std::ostringstream out;
-        int a_poi = (failure_at / 1000000)-1, paths_found = failure_at % 1000000;  // Decode the result
-        out << "POI " << a_poi << " CONNECTIVITY " << paths_found;
+        out << "POI " << result.failing_poi << " CONNECTIVITY " << result.found;
         return out.str();
     }
 }
@@ -199,56 +420,15 @@ std::string KCMC_Instance::m_connectivity(const int m, std::unordered_set<int> &
  * For faster results, limit the connectivity at "target".
  */
 int KCMC_Instance::get_connectivity(int buffer[], std::unordered_set<int> &inactive_sensors, int target) {
+    return this->get_connectivity(buffer, SensorSet(this->num_sensors, inactive_sensors), target);
+}
+int KCMC_Instance::get_connectivity(int buffer[], const SensorSet &inactive_sensors, int target) {
     // This method is a targeted variance to allow for a LARGE speedup in finding a smaller target
-
-    // Create the level graph
-    int level_graph[this->num_sensors];
-    this->level_graph(level_graph, inactive_sensors);
-
-    // Prepare the buffer set of "used" sensors
-    std::unordered_set<int> used_sensors;
-
-    // Create a loop control flag and pointer buffers, and a counter for the number of connected POIs
-    int paths_found, path_end, a_poi, predecessors[this->num_sensors], has_connection = 0;
-
-    // Run for each POI, returning at the first failure
-    for (a_poi=0; a_poi < this->num_pois; a_poi++) {
-        paths_found = 0;  // Clear the number of paths found for the POI
-        used_sensors = inactive_sensors;  // Reset the set of used sensors for each POI
-
-        // While there are still paths to be found
-        while (paths_found < target) {
-            std::fill(predecessors, predecessors+this->num_sensors, -2);  // Reset the predecessors buffer
-
-            // Find a path
-            path_end = this->find_path(a_poi, used_sensors, level_graph, predecessors);
-
-            // If the path ends in an invalid sensor, stop the WHILE loop
-            if (path_end == -1) {
-                buffer[a_poi] = paths_found;
-                has_connection += 1;
-                paths_found = target;
-
-            // If success, count the path and mark all the sensors with predecessors as "used"
-            } else {
-                paths_found += 1;  // Count the newfound path
-                // Unravel the path, marking each sensor in it as used
-                while (path_end != -1) {
-                    used_sensors.insert(path_end);
-                    path_end = predecessors[path_end];
-                    if (path_end == -2) {throw std::runtime_error("FORBIDDEN ADDRESS!");}
-                }
-                // Store if we've reached the target
-                if (paths_found >= target) {
-                    buffer[a_poi] = paths_found;
-                }
-            }
-        }
-    }
-
-    // Return the number of connected POIs
-    return has_connection;
+    return this->connectivity_blocks(buffer, connectivity_method, inactive_sensors, target);
 }
 int KCMC_Instance::get_connectivity(int buffer[], std::unordered_set<int> &inactive_sensors) {
     return this->get_connectivity(buffer, inactive_sensors, 10);  // Default value for target
 }
+int KCMC_Instance::get_connectivity(int buffer[], const SensorSet &inactive_sensors) {
+    return this->get_connectivity(buffer, inactive_sensors, 10);  // Default value for target
+}
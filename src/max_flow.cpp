@@ -0,0 +1,238 @@
+/** MAX_FLOW.cpp
+ * Implementation of the exact node-disjoint paths engine (unit-capacity Dinic on a node-split flow network), and of
+ * the exact m-connectivity services of the KCMC instance object
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::fill
+#include <cstdlib>    // getenv
+#include <cstring>    // strcmp
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* #####################################################################################################################
+ * NODE-SPLIT FLOW NETWORK
+ */
+
+/** FLOW NETWORK BUILDER
+ * Each sensor i is split in an entry node 2i and an exit node 2i+1, joined by an edge of capacity 1 (0 if inactive),
+ * so that at most one path crosses each sensor. The exit node of each sensor has an edge to the entry node of each
+ * sensor it communicates with, and an edge to the super-sink if it communicates with any sink. The super-source has
+ * an edge to the entry node of every sensor, of capacity 0 except for the sensors covering the POI being evaluated.
+ * Every edge has a paired reverse edge, and the edges of each node are stored contiguously (CSR).
+ */
+void DisjointPathsFlow::build(const int num_sensors, const CSR_Adjacency &sensor_sensor, const CSR_Adjacency &sensor_sink) {
+    int i, pass, edge;
+    this->num_sensors = num_sensors;
+    this->source = 2 * num_sensors;
+    this->sink = 2 * num_sensors + 1;
+
+    // Add an edge and its reverse. The first pass counts the edges of each node, the second pass places them
+    std::vector<int> cursor;
+    auto add_edge = [&](const int from, const int to, const int capacity, const bool counting) {
+        if (counting) {this->offsets[from+1]++; this->offsets[to+1]++; return -1;}
+        int forward = cursor[from]++, backward = cursor[to]++;
+        this->targets[forward] = to;
+        this->targets[backward] = from;
+        this->reverse[forward] = backward;
+        this->reverse[backward] = forward;
+        this->base_capacity[forward] = capacity;
+        this->base_capacity[backward] = 0;
+        return forward;
+    };
+
+    this->offsets.assign(2 * num_sensors + 3, 0);
+    this->split_edges.resize(num_sensors);
+    this->source_edges.resize(num_sensors);
+    for (pass=0; pass<2; pass++) {
+        if (pass == 1) {
+            for (i=0; i < 2 * num_sensors + 2; i++) {this->offsets[i+1] += this->offsets[i];}
+            cursor.assign(this->offsets.begin(), this->offsets.end() - 1);
+            this->targets.resize(this->offsets.back());
+            this->reverse.resize(this->offsets.back());
+            this->base_capacity.resize(this->offsets.back());
+        }
+        for (i=0; i<num_sensors; i++) {
+            edge = add_edge(2*i, 2*i + 1, 1, pass == 0);
+            if (pass == 1) {this->split_edges[i] = edge;}
+            edge = add_edge(this->source, 2*i, 0, pass == 0);
+            if (pass == 1) {this->source_edges[i] = edge;}
+            for (const int &neighbor : sensor_sensor[i]) {add_edge(2*i + 1, 2*neighbor, 1, pass == 0);}
+            if (not sensor_sink[i].empty()) {add_edge(2*i + 1, this->sink, 1, pass == 0);}
+        }
+    }
+
+    // Residual capacities and search buffers, reused by every evaluation
+    this->capacity = this->base_capacity;
+    this->levels.assign(2 * num_sensors + 2, -1);
+    this->current.resize(2 * num_sensors + 2);
+    this->work_queue.reserve(2 * num_sensors + 2);
+    this->touched.clear();
+}
+
+void DisjointPathsFlow::clear() {
+    this->num_sensors = 0;
+    for (std::vector<int> *buffer : {&this->offsets, &this->targets, &this->reverse, &this->capacity,
+                                     &this->base_capacity, &this->split_edges, &this->source_edges,
+                                     &this->levels, &this->current, &this->work_queue, &this->touched}) {
+        buffer->clear();
+    }
+}
+
+
+/** INACTIVE SENSORS
+ * Closes the split edge of each inactive sensor, and opens the split edge of every other sensor
+ */
+void DisjointPathsFlow::set_inactive(const SensorSet &inactive_sensors) {
+    int edge;
+    for (int i=0; i < this->num_sensors; i++) {
+        edge = this->split_edges[i];
+        this->base_capacity[edge] = ((i < inactive_sensors.size()) and inactive_sensors.contains(i)) ? 0 : 1;
+        this->capacity[edge] = this->base_capacity[edge];
+    }
+}
+
+
+/* #####################################################################################################################
+ * DINIC
+ */
+
+/** LEVEL GRAPH (BFS)
+ * Sets the distance from the super-source of every node reachable in the residual network, stopping at the level of
+ * the super-sink. Returns if the super-sink is reachable
+ */
+bool DisjointPathsFlow::build_levels() {
+    int node, edge, head = 0;
+    std::fill(this->levels.begin(), this->levels.end(), -1);
+    this->work_queue.clear();
+    this->levels[this->source] = 0;
+    this->work_queue.push_back(this->source);
+    while (head < (int)this->work_queue.size()) {
+        node = this->work_queue[head++];
+        if ((this->levels[this->sink] != -1) and (this->levels[node] >= this->levels[this->sink])) {break;}
+        for (edge = this->offsets[node]; edge < this->offsets[node+1]; edge++) {
+            if ((this->capacity[edge] > 0) and (this->levels[this->targets[edge]] == -1)) {
+                this->levels[this->targets[edge]] = this->levels[node] + 1;
+                this->work_queue.push_back(this->targets[edge]);
+            }
+        }
+    }
+    return this->levels[this->sink] != -1;
+}
+
+
+/** BLOCKING FLOW PATH (DFS)
+ * Finds one super-source to super-sink path in the level graph and pushes one unit of flow through it.
+ * Iterative, so paths as long as the number of sensors do not overflow the stack. The current edge of each node only
+ * moves forward within a phase, and dead ends are removed from the level graph, as in Dinic's algorithm.
+ * The path is kept in work_queue, which is free after the BFS
+ */
+bool DisjointPathsFlow::augment() {
+    int node = this->source, edge;
+    std::vector<int> &path = this->work_queue;
+    path.clear();
+    while (node != this->sink) {
+        for (edge = this->current[node]; edge < this->offsets[node+1]; edge++) {
+            if ((this->capacity[edge] > 0) and (this->levels[this->targets[edge]] == this->levels[node] + 1)) {break;}
+        }
+        this->current[node] = edge;
+        if (edge < this->offsets[node+1]) {
+            path.push_back(edge);
+            node = this->targets[edge];
+        } else {
+            this->levels[node] = -1;  // Dead end
+            if (path.empty()) {return false;}
+            edge = path.back();
+            path.pop_back();
+            node = this->targets[this->reverse[edge]];
+            this->current[node]++;
+        }
+    }
+    for (const int &path_edge : path) {
+        this->capacity[path_edge]--;
+        this->capacity[this->reverse[path_edge]]++;
+        this->touched.push_back(path_edge);
+    }
+    return true;
+}
+
+
+/** NODE-DISJOINT PATHS
+ * Number of node-disjoint paths (up to limit) from the given covering sensors of a POI to any sink, using only active
+ * sensors. The sensors crossed by the paths are added to used_sensors, if given. The residual network is restored
+ * afterwards, touching only the edges that carried flow.
+ */
+int DisjointPathsFlow::max_paths(const Neighbors &covering_sensors, const int limit, std::vector<int> *used_sensors) {
+    int flow = 0, node;
+
+    // Open the super-source edges of the covering sensors
+    for (const int &a_sensor : covering_sensors) {
+        this->capacity[this->source_edges[a_sensor]] = 1;
+        this->touched.push_back(this->source_edges[a_sensor]);
+    }
+
+    // Dinic phases, stopping as soon as the limit is reached
+    while ((flow < limit) and this->build_levels()) {
+        for (node=0; node < (int)this->current.size(); node++) {this->current[node] = this->offsets[node];}
+        while ((flow < limit) and this->augment()) {flow++;}
+    }
+
+    // Note the used sensors, as the sensors whose split edge carries flow, and restore the residual network.
+    // A split edge may be in the touched list more than once, so it is marked (reopened) when first noted
+    for (const int &edge : this->touched) {
+        if ((used_sensors != nullptr) and (this->targets[edge] < this->source) and (this->targets[edge] % 2 == 1)
+            and (this->targets[this->reverse[edge]] == this->targets[edge] - 1) and (this->capacity[edge] == 0)) {
+            used_sensors->push_back(this->targets[edge] / 2);
+            this->capacity[edge] = 1;
+        }
+    }
+    for (const int &edge : this->touched) {
+        this->capacity[edge] = this->base_capacity[edge];
+        this->capacity[this->reverse[edge]] = this->base_capacity[this->reverse[edge]];
+    }
+    this->touched.clear();
+    return flow;
+}
+
+
+/* #####################################################################################################################
+ * EXACT M-CONNECTIVITY SERVICES
+ */
+
+/** Connectivity method. Greedy unless the environment variable KCMC_CONNECTIVITY is "exact"
+ */
+int KCMC_Instance::connectivity_method = ((getenv("KCMC_CONNECTIVITY") != nullptr)
+                                          and (strcmp(getenv("KCMC_CONNECTIVITY"), "exact") == 0)) ? CONN_EXACT : CONN_GREEDY;
+
+
+/** Exact flow networks of a connectivity scratch, one for each thread
+ * Built on the first exact evaluation of the current graph, and then reused with another set of inactive sensors
+ */
+void KCMC_Instance::prepare_flow_networks(ConnectivityScratch &scratch, const int threads,
+                                          const SensorSet &inactive_sensors) {
+    if ((int)scratch.flows.size() < threads) {scratch.flows.resize(threads);}
+    for (int thread=0; thread<threads; thread++) {
+        if (scratch.flows[thread].empty()) {
+            scratch.flows[thread].build(this->num_sensors, this->sensor_sensor, this->sensor_sink);
+        }
+        scratch.flows[thread].set_inactive(inactive_sensors);
+    }
+}
+
+
+/** EXACT M-CONNECTIVITY SERVICES
+ * Same results encodings as the greedy services. Each used sensor is voted once for each POI whose paths cross it
+ */
+int KCMC_Instance::exact_m_connectivity(const int m, const SensorSet &inactive_sensors,
+                                        std::unordered_map<int, int> *all_used_sensors) {
+    CheckResult result = this->m_connectivity_blocks(m, CONN_EXACT, inactive_sensors, all_used_sensors);
+    if (not result.ok()) {return ((1+result.failing_poi)*1000000)+result.found;}  // Encoded the two ints
+    return (int)(result.total_paths);
+}
+int KCMC_Instance::exact_connectivity(int buffer[], const SensorSet &inactive_sensors, const int target) {
+    return this->connectivity_blocks(buffer, CONN_EXACT, inactive_sensors, target);
+}
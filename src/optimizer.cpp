@@ -1,10 +1,14 @@
 
 
 // STDLib dependencies
+#include <algorithm>  // std::min, std::binary_search
 #include <sstream>    // ostringstream
 #include <queue>      // queue
 #include <iostream>   // cin, cout, endl
 #include <iomanip>    // setfill, setw
+#include <limits>     // numeric_limits
+#include <mutex>      // mutex, lock_guard, unique_lock
+#include <condition_variable>  // condition_variable
 
 // Dependencies from this package
 #include "kcmc_instance.h"  // KCMC Instance class headers
@@ -17,20 +21,54 @@
  */
 
 int KCMC_Instance::local_optima(int k, int m, std::unordered_set<int> &inactive_sensors, std::unordered_set<int> *result_buffer) {
+    return this->local_optima(k, m, SensorSet(this->num_sensors, inactive_sensors), result_buffer);
+}
+int KCMC_Instance::local_optima(int k, int m, const SensorSet &inactive_sensors, std::unordered_set<int> *result_buffer) {
 
     // Prepare buffers
-    std::unordered_set<int> k_used_sensors, m_used_sensors, all_used_sensors;
+    SensorSet all_used_sensors;
+    std::unordered_set<int> m_used_sensors;
 
     // Check validity, recovering the used sensors for K coverage and M connectivity
-    this->validate(true, k, m, inactive_sensors, &k_used_sensors, &m_used_sensors);
+    this->validate(true, k, m, inactive_sensors, &all_used_sensors, &m_used_sensors);
 
     // Store the used sensors in the given buffer
-    all_used_sensors = set_merge(k_used_sensors, m_used_sensors);
-    result_buffer->clear();
-    *result_buffer = all_used_sensors;
+    for (const int &a_sensor : m_used_sensors) {all_used_sensors.insert(a_sensor);}
+    all_used_sensors.to_set(*result_buffer);
 
     // Return the real number of inactive sensors
-    return this->num_sensors - ((int)all_used_sensors.size());
+    return this->num_sensors - ((int)result_buffer->size());
+}
+
+
+/** COMMON ACTIVE NEIGHBORS
+ * Calls visit for each active sensor in both sorted neighbor lists, in increasing order. The lists are merged, or, if
+ * one is much shorter, each of its sensors is binary searched in the other. As the sensor-sensor adjacency is
+ * symmetric, the sensors connecting to both a and b are the common neighbors of a and b
+ */
+template <typename Visit>
+static void common_active_neighbors(const Neighbors &first, const Neighbors &second, const SensorSet &inactive_sensors,
+                                    Visit &visit) {
+    const int *a = first.begin(), *b = second.begin();
+    if ((first.size() * 16 < second.size()) or (second.size() * 16 < first.size())) {
+        const Neighbors &shorter = (first.size() < second.size()) ? first : second,
+                        &longer = (first.size() < second.size()) ? second : first;
+        for (const int &a_sensor : shorter) {
+            if (std::binary_search(longer.begin(), longer.end(), a_sensor) and (not inactive_sensors.contains(a_sensor))) {
+                visit(a_sensor);
+            }
+        }
+        return;
+    }
+    while ((a != first.end()) and (b != second.end())) {
+        if (*a < *b) {a++;}
+        else if (*b < *a) {b++;}
+        else {
+            if (not inactive_sensors.contains(*a)) {visit(*a);}
+            a++;
+            b++;
+        }
+    }
 }
 
 
@@ -41,28 +79,41 @@ int KCMC_Instance::local_optima(int k, int m, std::unordered_set<int> &inactive_
  * The "flooded" version of path A is a set of sensors that contains, for each connected triple ix-1, ix, ix+1 in A,
  * all sensors that connect both to ix-1 and ix+1. At the starting edge of A, ix-1 is P. At the end edge of A, ix+1 is S
  */
-int KCMC_Instance::flood(int k, int m, bool full,
-                         std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
+long long KCMC_Instance::flood(int k, int m, bool full,
+                               std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
+    return this->flood(k, m, full, SensorSet(this->num_sensors, inactive_sensors), visited_sensors);
+}
+long long KCMC_Instance::flood(int k, int m, bool full,
+                               const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
+    return this->flood(k, m, full, inactive_sensors, visited_sensors, this->workspace);
+}
+long long KCMC_Instance::flood(int k, int m, bool full, const SensorSet &inactive_sensors,
+                               std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace) {
 
     // Base case
     if (m < 1){return -1;}
 
-    // Create the level graph, loop controls and buffers
-    bool break_loop;
-    int level_graph[this->num_sensors], predecessors[this->num_sensors],
-        paths_found, path_end, a_poi, path_length, longest_required_path_length, previous, next_i,
-        total_paths_found = 0;
-
     // Update the level graph
-    this->level_graph(level_graph, inactive_sensors);
-
-    // Prepare the set of "used" sensors for each POI
-    std::unordered_set<int> used_sensors;
+    workspace.levels.resize(this->num_sensors);
+    this->level_graph(workspace.levels.data(), inactive_sensors);
 
     // Validate K-Coverage
-    if (this->fast_k_coverage(k, inactive_sensors, &used_sensors) != -1) {
+    if (not this->check_k_coverage(k, inactive_sensors).ok()) {
         throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)");
     }
+    return this->flood_from_levels(m, full, inactive_sensors, workspace.levels.data(), visited_sensors, workspace);
+}
+long long KCMC_Instance::flood_from_levels(int m, bool full, const SensorSet &inactive_sensors, const int level_graph[],
+                                           std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace) {
+
+    // Create the loop controls and buffers
+    bool break_loop;
+    int paths_found, path_end, a_poi, a_class, path_length, longest_required_path_length, previous, next_i;
+    long long total_paths_found = 0;
+
+    // Prepare the set of "used" sensors for each POI, and the path search buffers
+    SensorSet &used_sensors = workspace.used_sensors;
+    SearchWorkspace &search = workspace.search;
 
     // Reset the results buffer
     visited_sensors->clear();
@@ -74,8 +125,25 @@ int KCMC_Instance::flood(int k, int m, bool full,
         }
     }
 
+    // The flooded votes of the first POI of each class, replayed for the other POIs of the class
+    const PoiClasses &classes = this->poi_classes();
+    std::vector<int> class_votes, class_votes_begin(classes.size()), class_votes_end(classes.size()),
+                     class_paths(classes.size());
+    auto flood_vote = [&](const int a_sensor) {
+        vote(*visited_sensors, a_sensor);
+        class_votes.push_back(a_sensor);
+    };
+
     // Run for each POI, returning at the first failure
     for (a_poi=0; a_poi < this->num_pois; a_poi++) {
+        a_class = classes.of_poi[a_poi];
+        if (not classes.is_representative(a_poi)) {
+            for (int i=class_votes_begin[a_class]; i<class_votes_end[a_class]; i++) {vote(*visited_sensors, class_votes[i]);}
+            total_paths_found += class_paths[a_class];
+            continue;
+        }
+        class_votes_begin[a_class] = (int)class_votes.size();
+
         break_loop = false;  // Mark the loop for processing
         paths_found = 0;  // Clear the number of paths found for the POI
         longest_required_path_length = 0; // reset the stored length of the last found path
@@ -83,10 +151,8 @@ int KCMC_Instance::flood(int k, int m, bool full,
 
         // While the stopping criteria was not found
         while (not break_loop) {
-            std::fill(predecessors, predecessors+this->num_sensors, -2);  // Reset the predecessors buffer
-
             // Find a path
-            path_end = this->find_path(a_poi, used_sensors, level_graph, predecessors);
+            path_end = this->find_path(a_poi, used_sensors, level_graph, search);
 
             // If the path ends in an invalid sensor, mark the loop to end. If we do not have enough paths, throw error
             if (path_end == -1) {
@@ -111,7 +177,7 @@ int KCMC_Instance::flood(int k, int m, bool full,
                     path_length += 1;
 
                     // Get the previous sensor in the path
-                    previous = predecessors[path_end];
+                    previous = search.predecessor(path_end);
                     if (previous == -2) { throw std::runtime_error("FORBIDDEN ADDRESS!"); }
 
                     /* If the previous sensor is a POI and the next is a SINK
@@ -119,8 +185,8 @@ int KCMC_Instance::flood(int k, int m, bool full,
                      */
                     if ((previous == -1) and (next_i == -1)) {
                         for (const int &bridge: this->poi_sensor[a_poi]) {
-                            if (isin(this->sensor_sink, bridge) and (not isin(inactive_sensors, bridge))) {
-                                vote(*visited_sensors, bridge);
+                            if (isin(this->sensor_sink, bridge) and (not inactive_sensors.contains(bridge))) {
+                                flood_vote(bridge);
                             }
                         }
                     } else {
@@ -128,30 +194,24 @@ int KCMC_Instance::flood(int k, int m, bool full,
                          * Add all active sensors that cover the POI and connect to the path_end sensor to the result
                          */
                         if (previous == -1) {
-                            for (const int &cover: this->poi_sensor[a_poi]) {
-                                if (isin(this->sensor_sensor[cover], path_end) and (not isin(inactive_sensors, cover))) {
-                                    vote(*visited_sensors, cover);
-                                }
-                            }
+                            common_active_neighbors(this->poi_sensor[a_poi], this->sensor_sensor[path_end],
+                                                    inactive_sensors, flood_vote);
                         } else {
                             /* If the previous sensor is NOT a POI and the next IS a SINK
                              * Add all active sensors that connect to both the previous sensor and the sink
                              */
                             if (next_i == -1) {
                                 for (const int &conn: this->sensor_sensor[previous]) {
-                                    if (isin(this->sensor_sink, conn) and (not isin(inactive_sensors, conn))) {
-                                        vote(*visited_sensors, conn);
+                                    if (isin(this->sensor_sink, conn) and (not inactive_sensors.contains(conn))) {
+                                        flood_vote(conn);
                                     }
                                 }
                             } else {
                                 /* If the previous sensor is NOT a POI ant the next is NOT a sink
                                  * Add all active sensors that connect to both the previous and the next to the result
                                  */
-                                for (const int &conn: this->sensor_sensor[previous]) {
-                                    if (isin(this->sensor_sensor[conn], next_i) and (not isin(inactive_sensors, conn))) {
-                                        vote(*visited_sensors, conn);
-                                    }
-                                }
+                                common_active_neighbors(this->sensor_sensor[previous], this->sensor_sensor[next_i],
+                                                        inactive_sensors, flood_vote);
                             }
                         }
                     }
@@ -177,6 +237,8 @@ int KCMC_Instance::flood(int k, int m, bool full,
                 }
             }
         }
+        class_votes_end[a_class] = (int)class_votes.size();
+        class_paths[a_class] = paths_found;
     }
 
     // Success in each and every POI! Return the total of found paths
@@ -196,12 +258,16 @@ int KCMC_Instance::flood(int k, int m, bool full,
 
 int KCMC_Instance::reuse(int k, int m, int flood_level,
                          std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
+    return this->reuse(k, m, flood_level, SensorSet(this->num_sensors, inactive_sensors), visited_sensors);
+}
+int KCMC_Instance::reuse(int k, int m, int flood_level,
+                         const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
+    return this->reuse(k, m, flood_level, inactive_sensors, visited_sensors, this->workspace);
+}
+int KCMC_Instance::reuse(int k, int m, int flood_level, const SensorSet &inactive_sensors,
+                         std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace) {
 
-    // Local buffers
-    int num_paths, inv_frequency_array[this->num_sensors],
-        paths_found, path_end, a_poi, predecessors[this->num_sensors],
-        active_covering_sensors, add_sensor, pre_k_cov_sensors;
-    std::priority_queue<LevelNode, std::vector<LevelNode>, CompareLevelNode> queue;
+    long long num_paths;
 
     // First we clear out the output buffer
     visited_sensors->clear();
@@ -211,21 +277,39 @@ int KCMC_Instance::reuse(int k, int m, int flood_level,
      * NO-FLOOD  if the flood level is 0
      * MIN-FLOOD if the flood level is 1 (or more)
      */
-    if (flood_level == 0) {num_paths = this->fast_m_connectivity(m, inactive_sensors, visited_sensors);}
-    else {num_paths = this->flood(k, m, (flood_level < 0), inactive_sensors, visited_sensors);}
-    if (num_paths >= 1000000) {throw std::runtime_error("INVALID NUMBER OF PATHS!");}
+    if (flood_level == 0) {
+        CheckResult result = this->check_m_connectivity(m, inactive_sensors, visited_sensors);
+        if (not result.ok()) {throw std::runtime_error("INVALID NUMBER OF PATHS!");}
+        num_paths = result.total_paths;
+    }
+    else {num_paths = this->flood(k, m, (flood_level < 0), inactive_sensors, visited_sensors, workspace);}
+    return this->reuse_from_votes(k, m, num_paths, inactive_sensors, visited_sensors, workspace);
+}
+int KCMC_Instance::reuse_from_votes(int k, int m, long long num_paths, const SensorSet &inactive_sensors,
+                                    std::unordered_map<int, int> *visited_sensors, KCMC_Workspace &workspace) {
+
+    // Local buffers
+    int *inv_frequency_array, paths_found, path_end, a_poi,
+        active_covering_sensors, add_sensor, pre_k_cov_sensors;
+    std::priority_queue<LevelNode, std::vector<LevelNode>, CompareLevelNode> queue;
+
+    if (num_paths > std::numeric_limits<int>::max()) {throw std::runtime_error("INVALID NUMBER OF PATHS!");}  // The IFA holds ints
 
     /* Then format the frequency graph as a vector for minimization, similar to the level-graph
      * This is called the *inverse frequency array* (IFA). It holds no values smaller than 1.
      * In the IFA, sensors that were not found by the flood method have frequency num_paths
      * In the IFA, sensors that were found by the flood method have freqeuency num_paths-(orig. frequency)
-     * This inversion is done so the minimization loop can still be used
+     * This inversion is done so the minimization loop can still be used. It takes the place of the level graph
      */
-    std::fill(inv_frequency_array, inv_frequency_array + this->num_sensors, num_paths);
-    for (const auto &i : *visited_sensors) {inv_frequency_array[i.first] = num_paths - i.second;}
-
-    // Prepare the set of "used" sensors and clear the map of visited sensors
-    std::unordered_set<int> used_sensors, set_visited_sensors, final_inactive_sensors;
+    workspace.levels.resize(this->num_sensors);
+    inv_frequency_array = workspace.levels.data();
+    std::fill(inv_frequency_array, inv_frequency_array + this->num_sensors, (int)num_paths);
+    for (const auto &i : *visited_sensors) {inv_frequency_array[i.first] = (int)num_paths - i.second;}
+
+    // Prepare the set of "used" sensors, the path search buffers, and clear the map of visited sensors
+    SensorSet &used_sensors = workspace.used_sensors;
+    SearchWorkspace &search = workspace.search;
+    std::unordered_set<int> set_visited_sensors, final_inactive_sensors;
     visited_sensors->clear();
 
     // Run for each POI, returning at the first failure
@@ -235,10 +319,8 @@ int KCMC_Instance::reuse(int k, int m, int flood_level,
 
         // While there are still paths to be found
         while (paths_found < m) {
-            std::fill(predecessors, predecessors+this->num_sensors, -2);  // Reset the predecessors buffer
-
             // Find a path
-            path_end = this->find_path(a_poi, used_sensors, inv_frequency_array, predecessors);
+            path_end = this->find_path(a_poi, used_sensors, inv_frequency_array, search);
 
             // If the path ends in an invalid sensor, break the loop. Other POIs will fix it
             if (path_end == -1) {break;}
@@ -248,7 +330,7 @@ int KCMC_Instance::reuse(int k, int m, int flood_level,
                 while (path_end != -1) {
                     used_sensors.insert(path_end);
                     vote(*visited_sensors, path_end);  // Get the complete frequency map of all used sensors
-                    path_end = predecessors[path_end];
+                    path_end = search.predecessor(path_end);
                     if (path_end == -2) {throw std::runtime_error("FORBIDDEN ADDRESS!");}
                 }
             }
@@ -260,9 +342,9 @@ int KCMC_Instance::reuse(int k, int m, int flood_level,
      * Update the frequencies to the IFA
      * Increase (thus, subtract from) the frequency of each sensor the number of POIs it covers
      */
-    std::fill(inv_frequency_array, inv_frequency_array + this->num_sensors, num_paths);
-    for (const auto &i : *visited_sensors) {inv_frequency_array[i.first] = num_paths - i.second;}
-    for (const auto &i : this->sensor_poi) {inv_frequency_array[i.first] -= (int)(i.second.size());}
+    std::fill(inv_frequency_array, inv_frequency_array + this->num_sensors, (int)num_paths);
+    for (const auto &i : *visited_sensors) {inv_frequency_array[i.first] = (int)num_paths - i.second;}
+    for (int i=0; i<this->num_sensors; i++) {inv_frequency_array[i] -= this->sensor_poi.degree(i);}
 
     /* Add the sensors required to guarantee K-Coverage
      * Compute the frequency graph into the inverse frequency array
@@ -301,40 +383,169 @@ int KCMC_Instance::reuse(int k, int m, int flood_level,
     // Return the number of otherwise inactive sensors that were added only to guarantee k-coverage
     return ((int)(visited_sensors->size()))-pre_k_cov_sensors;
 }
+/** BEST REUSE
+ * Index of the reuse variation (max-flood, no-flood, min-flood) that uses the fewest sensors, preferring the max-flood
+ * variation, then the no-flood one
+ */
+static int best_variant(const int used[3]) {
+    if (used[0] <= used[1]) {return (used[0] <= used[2]) ? 0 : 2;}
+    else {return (used[1] <= used[2]) ? 1 : 2;}
+}
+
+/* Pool of the best reuse, shared by every instance, with a worker for each reuse variation. Started on first use */
+static WorkStealingPool &variant_pool() {
+    static WorkStealingPool pool(3);
+    return pool;
+}
+
 int KCMC_Instance::reuse(int k, int m,
                          std::unordered_set<int> &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
-    int added_min_r, min_r,  // Buffer for the number of nodes added for K-coverage and the resulting number of nodes
-        added_no_r,  no_r,   // for each pair of buffers, we use one of the reuse variations
-        added_max_r, max_r;
-    std::unordered_map<int, int> min_visited, no_visited, max_visited;
-    std::unordered_set<int> set_used_installation_spots;
-
-    added_min_r = this->reuse(k, m, -1, inactive_sensors, &min_visited);
-    setify(set_used_installation_spots, &min_visited);
-    min_r = (int)(set_used_installation_spots.size());
-    added_no_r  = this->reuse(k, m,  0, inactive_sensors, &no_visited);
-    setify(set_used_installation_spots, &no_visited);
-    no_r = (int)(set_used_installation_spots.size());
-    added_max_r = this->reuse(k, m,  1, inactive_sensors, &max_visited);
-    setify(set_used_installation_spots, &max_visited);
-    max_r = (int)(set_used_installation_spots.size());
+    return this->reuse(k, m, SensorSet(this->num_sensors, inactive_sensors), visited_sensors);
+}
+int KCMC_Instance::reuse(int k, int m,
+                         const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors) {
+    return this->reuse(k, m, inactive_sensors, visited_sensors, this->workspace);
+}
+int KCMC_Instance::reuse(int k, int m, const SensorSet &inactive_sensors, std::unordered_map<int, int> *visited_sensors,
+                         KCMC_Workspace &workspace) {
+    const int flood_levels[3] = {-1, 0, 1};  // One for each reuse variation
+    int added[3], used[3], best;  // Number of nodes added for K-coverage and the resulting number of nodes of each
+    std::unordered_map<int, int> variant_visited[3];
+
+    // The variations only read the instance, each with its own workspace (and connectivity buffers leased from the
+    // instance), so they run at once on the variant pool. The POI classes are built beforehand. As the pool is shared,
+    // this call waits for its own variations only, and rethrows the first exception in variation order
+    std::mutex done_lock;
+    std::condition_variable all_done;
+    std::exception_ptr errors[3];
+    int left = 3;
+    this->poi_classes();
+    workspace.variants.resize(2);
+    for (int variant=0; variant<3; variant++) {
+        variant_pool().submit([&, variant]() {
+            try {
+                std::unordered_set<int> set_used_installation_spots;
+                KCMC_Workspace &variant_workspace = (variant == 0) ? workspace : workspace.variants[variant-1];
+                added[variant] = this->reuse(k, m, flood_levels[variant], inactive_sensors, &variant_visited[variant],
+                                             variant_workspace);
+                setify(set_used_installation_spots, &variant_visited[variant]);
+                used[variant] = (int)(set_used_installation_spots.size());
+            } catch (...) {errors[variant] = std::current_exception();}
+            std::lock_guard<std::mutex> guard(done_lock);
+            if (--left == 0) {all_done.notify_one();}
+        });
+    }
+    {
+        std::unique_lock<std::mutex> guard(done_lock);
+        all_done.wait(guard, [&]() {return left == 0;});
+    }
+    for (const std::exception_ptr &error : errors) {if (error) {std::rethrow_exception(error);}}
 
     // Return the smallest
-    if (min_r <= no_r) {
-        if (min_r <= max_r) {
-            visited_sensors->insert(min_visited.begin(), min_visited.end());
-            return added_min_r;
-        } else {
-            visited_sensors->insert(max_visited.begin(), max_visited.end());
-            return added_max_r;
+    best = best_variant(used);
+    visited_sensors->insert(variant_visited[best].begin(), variant_visited[best].end());
+    return added[best];
+}
+
+
+/* #####################################################################################################################
+ * HEURISTIC SESSION
+ */
+
+/** Heuristic session constructor
+ * Nothing is computed until first used
+ */
+HeuristicSession::HeuristicSession(KCMC_Instance *instance, const int k, const int m, const SensorSet &inactive_sensors)
+    : instance(instance), k(k), m(m), inactive(inactive_sensors) {
+    inactive_sensors.require_width(instance->num_sensors);
+}
+
+
+/** Reuse variation of a flood level: max-flood (lower than 0), no-flood (0) or min-flood (1 or more)
+ */
+static int variant_of(const int flood_level) {
+    return (flood_level < 0) ? 0 : ((flood_level == 0) ? 1 : 2);
+}
+
+
+/** Shared stages
+ * The level graph is computed once the K-coverage is checked, as in flood. The no-flood votes are those of the
+ * m-connectivity check, and a failed check is kept so that each preprocessor reports it as it would on its own
+ */
+const int *HeuristicSession::level_graph() {
+    std::lock_guard<std::mutex> guard(this->levels_lock);
+    if (this->levels.empty()) {
+        std::vector<int> levels(this->instance->num_sensors);
+        this->instance->level_graph(levels.data(), this->inactive);
+        if (not this->instance->check_k_coverage(this->k, this->inactive).ok()) {
+            throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)");
         }
+        this->levels.swap(levels);
+    }
+    return this->levels.data();
+}
+void HeuristicSession::prepare() {
+    if (this->m >= 1) {this->level_graph();}  // As the floods, which only need it for M of 1 or more
+}
+const HeuristicSession::Votes &HeuristicSession::votes(const int variant) {
+    Votes &result = this->variant_votes[variant];
+    if (result.done) {return result;}
+    if (variant == 1) {
+        CheckResult check = this->instance->check_m_connectivity(this->m, this->inactive, &result.votes);
+        result.connected = check.ok();
+        result.num_paths = check.total_paths;
+    } else if (this->m < 1) {
+        result.num_paths = -1;  // Same as flood
     } else {
-        if (no_r <= max_r) {
-            visited_sensors->insert(no_visited.begin(), no_visited.end());
-            return added_no_r;
-        } else {
-            visited_sensors->insert(max_visited.begin(), max_visited.end());
-            return added_max_r;
-        }
+        result.num_paths = this->instance->flood_from_levels(this->m, (variant == 0), this->inactive,
+                                                             this->level_graph(), &result.votes,
+                                                             this->workspaces[variant]);
     }
+    result.done = true;
+    return result;
+}
+const HeuristicSession::Reuse &HeuristicSession::reuse_variant(const int variant) {
+    Reuse &result = this->variant_reuse[variant];
+    if (result.done) {return result;}
+    const Votes &flood = this->votes(variant);
+    if (not flood.connected) {throw std::runtime_error("INVALID NUMBER OF PATHS!");}
+    result.visited = flood.votes;
+    result.added = this->instance->reuse_from_votes(this->k, this->m, flood.num_paths, this->inactive,
+                                                    &result.visited, this->workspaces[variant]);
+    result.used = (int)(result.visited.size());
+    result.done = true;
+    return result;
+}
+
+
+/** Session preprocessors
+ * Same results as KCMC_Instance::local_optima, flood and reuse
+ */
+int HeuristicSession::local_optima(std::unordered_set<int> *result_buffer) {
+    SensorSet all_used_sensors;
+    if (not this->instance->check_k_coverage(this->k, this->inactive, &all_used_sensors, nullptr).ok()) {
+        throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT COVERAGE)");
+    }
+    const Votes &no_flood = this->votes(1);
+    if (not no_flood.connected) {throw std::runtime_error("INVALID INSTANCE! (INSUFFICIENT CONNECTIVITY)");}
+    for (const auto &i : no_flood.votes) {all_used_sensors.insert(i.first);}
+    all_used_sensors.to_set(*result_buffer);
+    return this->instance->num_sensors - ((int)result_buffer->size());
+}
+long long HeuristicSession::flood(const bool full, std::unordered_map<int, int> *visited_sensors) {
+    const Votes &flood = this->votes(full ? 0 : 2);
+    *visited_sensors = flood.votes;
+    return flood.num_paths;
+}
+int HeuristicSession::reuse(const int flood_level, std::unordered_map<int, int> *visited_sensors) {
+    const Reuse &result = this->reuse_variant(variant_of(flood_level));
+    *visited_sensors = result.visited;
+    return result.added;
+}
+int HeuristicSession::reuse(std::unordered_map<int, int> *visited_sensors) {
+    int used[3];
+    for (int variant=0; variant<3; variant++) {used[variant] = this->reuse_variant(variant).used;}
+    const Reuse &best = this->variant_reuse[best_variant(used)];
+    visited_sensors->insert(best.visited.begin(), best.visited.end());
+    return best.added;
 }
@@ -33,25 +33,30 @@
  * @param weight_k
  * @param weight_m
  * @param chromo
+ * @param coverage_state  Coverage of the previously evaluated chromosome, synced to this one
+ * @param certificate     Connectivity certificate of the previously evaluated chromosome, updated to this one
+ * @param connectivity    Buffer for the connectivity at each POI
  * @return
  */
-double fitness_binary(KCMC_Instance *wsn, int K, int M, double weight_k, double weight_m, int *chromo) {
+double fitness_binary(KCMC_Instance *wsn, int K, int M, double weight_k, double weight_m, int *chromo,
+                      CoverageState *coverage_state, ConnectivityCertificate *certificate, int connectivity[]) {
 
     // Define reused buffers
     int i, severity;
     double fitness;
 
     // Get the set of inactive sensors, the coverage and connectivity array at each POI
-    std::unordered_set<int> inactive_sensors;
+    SensorSet inactive_sensors;
     setify(inactive_sensors, wsn->num_sensors, chromo, 0);
 
     // Compute the starting fitness as the number of active sensors
-    fitness = (double)(wsn->num_pois - inactive_sensors.size());
+    fitness = (double)(wsn->num_pois - inactive_sensors.count());
 
-    // Get the coverage and connectivity at each POI
-    int coverage[wsn->num_pois], connectivity[wsn->num_pois];
-    wsn->get_coverage(coverage, inactive_sensors);
-    wsn->get_connectivity(connectivity, inactive_sensors, M);
+    // Get the coverage and connectivity at each POI. The coverage is updated only at the sensors that differ from the
+    // previously evaluated chromosome. With exact paths, only the POIs whose certified paths were broken are re-routed
+    coverage_state->sync(inactive_sensors);
+    const int *coverage = coverage_state->coverage();
+    wsn->get_connectivity(connectivity, inactive_sensors, M, certificate);
 
     // Compute the penalties on validity violations and return the total fitness
     for (i=0; i<wsn->num_pois; i++) {
@@ -85,21 +90,22 @@ int genalg_binary(
     KCMC_Instance *wsn, int K, int M,
     double w_valid, double w_invalid
 ) {
-    // Prepare buffers
+    // Prepare buffers. The population is a single heap block, with a row of chromo_size genes for each individual
     int i, best, num_generation, parent_0, parent_1,
-        chromo_size = wsn->num_sensors,
-        population[pop_size][chromo_size];
-    double pop_entropy, best_fitness_ever = WORST_FITNESS, fitness[pop_size], colunar_entropy[chromo_size];
-    std::vector<int> selection;
+        chromo_size = wsn->num_sensors;
+    double pop_entropy, best_fitness_ever = WORST_FITNESS;
+    std::vector<int> selection, genes((size_t)(pop_size) * chromo_size), connectivity(wsn->num_pois);
+    std::vector<double> fitness(pop_size), colunar_entropy(chromo_size);
+    CoverageState coverage_state(wsn, K);
+    ConnectivityCertificate certificate;
 
     // FLAGS
     bool SAFE = true,
          ELITISM = true;  // The best individual always stays intact in the next generation
 
-    // Prepare an alternate buffer for the population
-    // Look, it's C++, OK? Sometimes things like that are necessary
-    int *pop[pop_size];
-    if (SAFE) {for (size_t j = 0; j<pop_size; j++) {pop[j] = population[j];}}
+    // Prepare the rows of the population
+    std::vector<int *> population(pop_size);
+    for (i=0; i<pop_size; i++) {population[i] = genes.data() + (size_t)(i) * chromo_size;}
 
     // Generate a random population
     for (i=0; i<pop_size; i++) {individual_creation(one_bias, chromo_size, population[i]);}
@@ -112,18 +118,23 @@ int genalg_binary(
     for (num_generation=0; num_generation<max_generations+1; num_generation++) {
 
         // If in safe mode, inspect the population once every INSPECTION_FREQUENCY generations
-        if (SAFE & ((num_generation % INSPECTION_FREQUENCY) == 0)) {inspect_population(pop_size, wsn->num_sensors, pop);}
+        if (SAFE & ((num_generation % INSPECTION_FREQUENCY) == 0)) {
+            inspect_population(pop_size, wsn->num_sensors, population.data());
+        }
 
         // Evaluate the population and find the best
-        for (i=0; i<pop_size; i++) {fitness[i] = fitness_binary(wsn, K, M, w_valid, w_invalid, population[i]);}
-        best = ((int)(std::min_element(fitness, fitness + pop_size) - fitness));
+        for (i=0; i<pop_size; i++) {
+            fitness[i] = fitness_binary(wsn, K, M, w_valid, w_invalid, population[i], &coverage_state, &certificate,
+                                        connectivity.data());
+        }
+        best = ((int)(std::min_element(fitness.begin(), fitness.end()) - fitness.begin()));
 
         // If the current best is the best ever found,
         // or if we have run the appropriate interval of generations.
         if (((num_generation % print_interval) == 0) | (fitness[best] < best_fitness_ever)) {
 
             // Compute the population's entropy, average and by column
-            pop_entropy = population_entropy(colunar_entropy, pop_size, chromo_size, pop);
+            pop_entropy = population_entropy(colunar_entropy.data(), pop_size, chromo_size, population.data());
 
             // Print the best individual in the population
             printout(num_generation, pop_entropy, chromo_size, population[best], fitness[best]);
@@ -134,7 +145,7 @@ int genalg_binary(
         }
 
         // Select individuals for next generation
-        selection_roulette(sel_size, &selection, pop_size, fitness);
+        selection_roulette(sel_size, &selection, pop_size, fitness.data());
 
         // For every population position that was *not* selected
         for (i=0; i<pop_size; i++) {
@@ -180,7 +191,10 @@ void help() {
     std::cout << "M >= K is the desired M connectivity" << std::endl;
     std::cout << "w_valid > 0.0 is the double maximum fitness of valid solutions" << std::endl;
     std::cout << "w_invalid > 0.0 is the double maximum fitness of valid solutions" << std::endl;
-    std::cout << "<instance> is the serialized KCMC instance" << std::endl;
+    std::cout << "<instance> is the serialized KCMC instance, the path of a text or binary KCMC instance file, or - for STDIN" << std::endl;
+    std::cout << "Set the environment variable KCMC_CACHE_DIR to cache instances regenerated from their keys" << std::endl;
+    std::cout << "Set the environment variable KCMC_CONNECTIVITY=exact to validate M connectivity with exact max-flow instead of greedy paths" << std::endl;
+    std::cout << "Set the environment variable KCMC_THREADS to evaluate M connectivity with that many threads (0 for all cores)" << std::endl;
     exit(0);
 }
 
@@ -216,11 +230,14 @@ int main(int argc, char* const argv[]) {
     m = std::stoi(argv[7]);
     w_valid = std::stod(argv[8]);
     w_invalid = std::stod(argv[9]);
-    auto *instance = new KCMC_Instance(argv[10]);
-    std::unordered_set<int> emptyset, ignoredset;
-
-    if (instance->fast_k_coverage(k, emptyset) != -1) {throw std::runtime_error("INVALID INSTANCE!");}
-    if (instance->fast_m_connectivity(m, emptyset, &ignoredset) != -1) {throw std::runtime_error("INVALID INSTANCE!");}
+    auto *instance = KCMC_Instance::load(argv[10]);
+    // Every chromosome is evaluated against the same instance, so a coverage matrix is built if the POIs are dense
+    if (CoverageMatrix::worth_building(instance->poi_sensor, instance->num_sensors)) {instance->build_coverage_matrix();}
+    SensorSet emptyset(instance->num_sensors);
+    std::unordered_map<int, int> ignoredset;
+
+    if (not instance->check_k_coverage(k, emptyset).ok()) {throw std::runtime_error("INVALID INSTANCE!");}
+    if (not instance->check_m_connectivity(m, emptyset, &ignoredset).ok()) {throw std::runtime_error("INVALID INSTANCE!");}
 
     // Optimize the instance using one of the optimization methods
     genalg_binary(&unused_installation_spots, print_interval, 100000,
@@ -6,7 +6,12 @@
 #include <iostream>   // cin, cout, endl
 #include <chrono>     // time functions
 #include <iomanip>    // setfill, setw
-#include <cstring>    // strcpy
+#include <fstream>    // ifstream
+#include <string>     // string, getline, stoi
+#include <atomic>     // atomic
+#include <deque>      // deque
+#include <mutex>      // mutex, lock_guard, unique_lock
+#include <condition_variable>  // condition_variable
 
 // Dependencies from this package
 #include "kcmc_instance.h"  // KCMC Instance class headers
@@ -18,24 +23,23 @@
  * */
 
 
-void printout_short(KCMC_Instance *instance, int k, int m,
-                    const int num_sensors, const std::string operation,
-                    const long duration, std::unordered_set<int> &used_installation_spots) {
+std::string printout_short(KCMC_Instance *instance, int k, int m,
+                           const int num_sensors, const std::string operation,
+                           const long duration, std::unordered_set<int> &used_installation_spots) {
 
     // Validate the instance
     std::unordered_set<int> inactive_sensors;
     instance->invert_set(used_installation_spots, &inactive_sensors);
     bool valid = instance->validate(false, k, m, inactive_sensors);
 
-    // Reformat the used installation spots as an array of 0/1
-    int individual[num_sensors];
-    std::fill(individual, individual+num_sensors, 0);
-    for (const int &used_spot : used_installation_spots) { individual[used_spot] = 1; }
+    // Reformat the used installation spots as a string of 0/1
+    std::string individual(num_sensors, '0');
+    for (const int &used_spot : used_installation_spots) { individual[used_spot] = '1'; }
 
     // Prepare the output buffer
     std::ostringstream out;
 
-    // Print a line with:
+    // Format a line with:
     // - The key of the instance
     // - The name of the current operation
     // - The amount of microsseconds the method needed to run
@@ -48,24 +52,294 @@ void printout_short(KCMC_Instance *instance, int k, int m,
         << "\t" << used_installation_spots.size()
         << "\t" << std::fixed << std::setprecision(5) << (double)(inactive_sensors.size()) / (double)num_sensors
         << "\t";
-    for (int i=0; i<num_sensors; i++) {out << individual[i];}
-    // Flush
-    std::cout << out.str() << std::endl;
+    out << individual;
+    return out.str();
 }
 
 
 void help() {
     std::cout << "Please, use the correct input for the KCMC instance heuristic optimizer:" << std::endl << std::endl;
     std::cout << "./optimizer_dinic <instance> <k> <m>" << std::endl;
+    std::cout << "./optimizer_dinic --batch <file>" << std::endl;
     std::cout << "  where:" << std::endl << std::endl;
-    std::cout << "<instance> is the serialized KCMC instance" << std::endl;
+    std::cout << "<instance> is the serialized KCMC instance, the path of a text or binary KCMC instance file, or - for STDIN" << std::endl;
+    std::cout << "Set the environment variable KCMC_CACHE_DIR to cache instances regenerated from their keys" << std::endl;
+    std::cout << "Set the environment variable KCMC_CONNECTIVITY=exact to validate M connectivity with exact max-flow instead of greedy paths" << std::endl;
+    std::cout << "Set the environment variable KCMC_THREADS to evaluate M connectivity with that many threads (0 for all cores)" << std::endl;
     std::cout << "Integer 0 < K < 10 is the desired K coverage" << std::endl;
     std::cout << "Integer 0 < M < 10 is the desired M connectivity" << std::endl;
     std::cout << "K migth be the pair K,M in the format (K{k}M{m}). In this case M is ignored" << std::endl;
+    std::cout << "<file> has an instance and its (K{k}M{m}) pair in each line, separated by a TAB or by the last | (as in" << std::endl;
+    std::cout << "  the instances CSV), or is - for STDIN. Every line runs in the same process, and results are streamed in order" << std::endl;
+    std::cout << "  With KCMC_THREADS above 1, the heuristics of many lines run at once on that many threads, each heuristic" << std::endl;
+    std::cout << "  in a single thread, with the same results in the same order" << std::endl;
     exit(0);
 }
 
 
+/* K AND M PARSER
+ * Reads the pair in the format (K{k}M{m}), with or without the parenthesis
+ */
+bool parse_km(const std::string &pair, int *k, int *m) {
+    size_t k_at = pair.find_first_of("Kk"), m_at = pair.find_first_of("Mm");
+    if ((k_at == std::string::npos) or (m_at == std::string::npos) or (m_at < k_at)) {return false;}
+    try {
+        *k = std::stoi(pair.substr(k_at + 1));
+        *m = std::stoi(pair.substr(m_at + 1));
+    } catch (const std::exception &exc) {return false;}
+    return true;
+}
+
+
+/* HEURISTICS
+ * Each heuristic runs in a session shared by the heuristics of the same instance, K and M, sharing the level graph,
+ *   the flood votes and the no-flood paths. The shared work is timed in the first heuristic that needs it, or, if it
+ *   was done up front, given as the shared duration (in microseconds) to add to the runtime of that heuristic.
+ * They are numbered in output order: dinic, min flood, max flood, no/min/max flood reuse and best reuse
+ */
+#define NUM_HEURISTICS 7
+
+std::string run_heuristic(HeuristicSession &session, KCMC_Instance *instance, const int k, const int m,
+                          const int heuristic, const long shared_duration = 0) {
+    long long num_paths = 0;
+    std::string operation;
+    std::unordered_set<int> set_used_installation_spots;
+    std::unordered_map<int, int> used_installation_spots;
+
+    // Run the heuristic, on the clock
+    auto start = std::chrono::high_resolution_clock::now();
+    switch (heuristic) {
+        case 0: session.local_optima(&set_used_installation_spots); break;  // First local optima, from DINIC
+        case 1: num_paths = session.flood(false, &used_installation_spots); break;
+        case 2: num_paths = session.flood(true, &used_installation_spots); break;
+        case 3: num_paths = session.reuse(0, &used_installation_spots); break;
+        case 4: num_paths = session.reuse(1, &used_installation_spots); break;
+        case 5: num_paths = session.reuse(-1, &used_installation_spots); break;
+        default: num_paths = session.reuse(&used_installation_spots); break;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    long duration = shared_duration + std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    // Name the operation, with the number of paths found (flood) or of added sensors for k-coverage (reuse)
+    switch (heuristic) {
+        case 0: operation = "dinic"; break;
+        case 1: operation = "min_flood_"; break;
+        case 2: operation = "max_flood_"; break;
+        case 3: operation = "no_reuse_"; break;
+        case 4: operation = "min_reuse_"; break;
+        case 5: operation = "max_reuse_"; break;
+        default: operation = "best_reuse_"; break;
+    }
+    if (heuristic != 0) {
+        operation += std::to_string(num_paths);
+        setify(set_used_installation_spots, &used_installation_spots);
+    }
+    return printout_short(instance, k, m, instance->num_sensors, operation, duration, set_used_installation_spots);
+}
+
+
+/* Runs every heuristic on the instance, printing a line for each
+ */
+void run_heuristics(KCMC_Instance *instance, const int k, const int m) {
+    // Print the header
+    // printf("Key\tK\tM\tOperation\tRuntime\tValid\tObjective\tCompression\tSolution\n");
+    HeuristicSession session(instance, k, m, SensorSet(instance->num_sensors));
+    for (int heuristic=0; heuristic<NUM_HEURISTICS; heuristic++) {
+        std::cout << run_heuristic(session, instance, k, m, heuristic) << std::endl;
+    }
+}
+
+
+/* BATCH LINE PARSER
+ * Splits the line in the instance source and its K and M. Returns the error of the line, or an empty string
+ */
+std::string parse_batch_line(const std::string &line, std::string *source, int *k, int *m) {
+    size_t split_at = line.find('\t');
+    if (split_at == std::string::npos) {split_at = line.rfind('|');}
+    if (split_at == std::string::npos) {return "MISSING (K{k}M{m}) PAIR";}
+    std::string pair = line.substr(split_at + 1);
+    *source = line.substr(0, split_at);
+    source->erase(source->find_last_not_of(' ') + 1);
+    source->erase(0, source->find_first_not_of(' '));
+    if (not parse_km(pair, k, m)) {return "INVALID (K{k}M{m}) PAIR " + pair;}
+    return "";
+}
+
+
+/* BATCH MODE
+ * Runs the heuristics for each line of the input. Consecutive lines of the same instance share it, and a line that
+ * fails is reported to STDERR without stopping the others
+ */
+void run_batch(std::istream &input) {
+    int k, m, line_number = 0;
+    std::string line, source, error, loaded_source;
+    KCMC_Instance *instance = nullptr;
+
+    while (std::getline(input, line)) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {continue;}  // Blank line
+
+        error = parse_batch_line(line, &source, &k, &m);
+        if (not error.empty()) {
+            std::cerr << "LINE " << line_number << ": " << error << std::endl;
+            continue;
+        }
+
+        try {
+            if ((instance == nullptr) or (source != loaded_source)) {
+                delete instance;
+                instance = nullptr;
+                instance = KCMC_Instance::load(source);
+                loaded_source = source;
+            }
+            run_heuristics(instance, k, m);
+        } catch (const std::exception &exc) {
+            std::cerr << "LINE " << line_number << ": " << exc.what() << std::endl;
+        }
+    }
+    delete instance;
+}
+
+
+/* SCHEDULED BATCH MODE
+ * Same output as the batch mode, with the heuristics of many lines running at once on a work stealing pool.
+ * The heuristics of a line are split in three chains, one for each reuse variant, as each reuse builds on the flood of
+ *   the same session: dinic then no-flood reuse, min flood then min-flood reuse, and max flood then max-flood reuse.
+ *   The last chain of a line to finish runs the best reuse, which picks among the three variants.
+ * A line starts as a single task, which prepares the level graph shared by the floods and then submits the three
+ *   chains to the deque of its own worker, so that idle workers steal them. Each heuristic is timed on its own
+ *   worker, and each evaluates M connectivity in a single thread, so that the runtimes are those of the heuristic
+ *   alone, with no chain waiting for another. The level graph is timed on its own, and charged to the min flood, the
+ *   heuristic that pays for it in the batch mode. Finished lines are printed in input order, as soon as every line
+ *   before them is printed too. A line stops at its first failure, reported to STDERR after the lines before it.
+ * At most jobs_per_worker lines per worker are in flight, so the input is streamed as in the batch mode
+ */
+struct BatchJob {
+    int line_number, k, m;
+    std::shared_ptr<KCMC_Instance> instance;
+    std::unique_ptr<HeuristicSession> session;
+    std::string outputs[NUM_HEURISTICS], errors[NUM_HEURISTICS];
+    bool failed[NUM_HEURISTICS] = {false};
+    long shared_duration = 0;  // Of the level graph shared by the floods, charged to the min flood
+    std::atomic<int> chains_left{0};
+    bool done = false;  // Under the output lock
+};
+
+void run_scheduled_batch(std::istream &input, const int num_workers) {
+    const int chains[3][2] = {{0, 3}, {1, 4}, {2, 5}}, jobs_per_worker = 4;
+    int k, m, line_number = 0;
+    std::string line, source, error, loaded_source;
+    std::shared_ptr<KCMC_Instance> instance;
+    std::deque<std::unique_ptr<BatchJob>> jobs;  // In flight, in input order
+    std::mutex output_lock;
+    std::condition_variable job_done;
+
+    // Print and release the finished jobs at the front
+    auto finish = [&](BatchJob *job) {
+        std::lock_guard<std::mutex> guard(output_lock);
+        job->done = true;
+        while ((not jobs.empty()) and jobs.front()->done) {
+            BatchJob &front = *jobs.front();
+            for (int heuristic=0; heuristic<NUM_HEURISTICS; heuristic++) {
+                if (front.failed[heuristic]) {
+                    std::cerr << "LINE " << front.line_number << ": " << front.errors[heuristic] << std::endl;
+                    break;
+                }
+                std::cout << front.outputs[heuristic] << "\n";
+            }
+            std::cout.flush();
+            jobs.pop_front();
+        }
+        job_done.notify_all();
+    };
+
+    // Run a chain of heuristics of a job, up to its first failure. The last chain runs the best reuse
+    auto run_chain = [&](BatchJob *job, const int chain) {
+        int heuristic;
+        for (const int &chain_heuristic : chains[chain]) {
+            try {
+                job->outputs[chain_heuristic] = run_heuristic(*job->session, job->instance.get(), job->k, job->m,
+                                                              chain_heuristic,
+                                                              (chain_heuristic == 1) ? job->shared_duration : 0);
+            } catch (const std::exception &exc) {
+                job->failed[chain_heuristic] = true;
+                job->errors[chain_heuristic] = exc.what();
+                break;
+            }
+        }
+        if (job->chains_left.fetch_sub(1) != 1) {return;}  // Not the last chain of the job
+        for (heuristic=0; heuristic < NUM_HEURISTICS-1; heuristic++) {if (job->failed[heuristic]) {break;}}
+        if (heuristic == NUM_HEURISTICS-1) {
+            try {
+                job->outputs[heuristic] = run_heuristic(*job->session, job->instance.get(), job->k, job->m, heuristic);
+            } catch (const std::exception &exc) {
+                job->failed[heuristic] = true;
+                job->errors[heuristic] = exc.what();
+            }
+        }
+        finish(job);
+    };
+
+    // Prepare the shared level graph of a job, and submit its chains to the deque of this worker. A failure of the
+    // K-coverage check is that of the dinic local optima, the first heuristic of the line
+    WorkStealingPool pool(num_workers);
+    auto run_job = [&](BatchJob *job) {
+        auto start = std::chrono::high_resolution_clock::now();
+        try {job->session->prepare();}
+        catch (const std::exception &exc) {
+            job->failed[0] = true;
+            job->errors[0] = exc.what();
+            finish(job);
+            return;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        job->shared_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        job->chains_left = 3;
+        for (int chain=0; chain<3; chain++) {pool.submit([&run_chain, job, chain]() {run_chain(job, chain);});}
+    };
+
+    while (std::getline(input, line)) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {continue;}  // Blank line
+
+        // Wait for room, and queue the job in input order
+        BatchJob *job = new BatchJob();
+        job->line_number = line_number;
+        {
+            std::unique_lock<std::mutex> guard(output_lock);
+            job_done.wait(guard, [&]() {return (int)jobs.size() < jobs_per_worker * num_workers;});
+            jobs.emplace_back(job);
+        }
+
+        // A line that cannot be parsed or loaded is finished at once, with its error
+        error = parse_batch_line(line, &source, &k, &m);
+        if (error.empty()) {
+            try {
+                if ((not instance) or (source != loaded_source)) {
+                    instance.reset();
+                    instance.reset(KCMC_Instance::load(source));
+                    loaded_source = source;
+                    instance->poi_classes();  // Built once, before the workers share the instance
+                }
+                job->k = k;
+                job->m = m;
+                job->instance = instance;
+                job->session.reset(new HeuristicSession(instance.get(), k, m, SensorSet(instance->num_sensors)));
+            } catch (const std::exception &exc) {error = exc.what();}
+        }
+        if (not error.empty()) {
+            job->failed[0] = true;
+            job->errors[0] = error;
+            finish(job);
+            continue;
+        }
+
+        pool.submit([&run_job, job]() {run_job(job);});
+    }
+    pool.wait();
+}
+
+
 int main(int argc, char* const argv[]) {
     if (argc < 3) { help(); }
 
@@ -77,118 +351,38 @@ int main(int argc, char* const argv[]) {
     signal(SIGTERM, exit_signal_handler);
     signal(SIGKILL, exit_signal_handler);
 
+    // Batch mode, from a file or STDIN
+    if (std::string(argv[1]) == "--batch") {
+        std::ifstream file;
+        if (std::string(argv[2]) != "-") {
+            file.open(argv[2]);
+            if (not file) {throw std::runtime_error("UNABLE TO OPEN BATCH FILE " + std::string(argv[2]));}
+        }
+        std::istream &input = (std::string(argv[2]) == "-") ? std::cin : file;
+
+        // With many threads, the heuristics of many lines run at once instead, each in a single thread
+        int num_workers = KCMC_Instance::num_threads;
+        if (num_workers > 1) {
+            KCMC_Instance::num_threads = 1;
+            run_scheduled_batch(input, num_workers);
+        } else {run_batch(input);}
+        return 0;
+    }
+
     // Buffers
-    int k, m, num_paths;
-    std::string serialized_instance, alt_k;
-    std::unordered_set<int> emptyset, seed_sensors, set_used_installation_spots;
-    std::unordered_map<int, int> used_installation_spots;
+    int k, m;
 
     /* Parse base Arguments
      * Serialized KCMC Instance (will be immediately de-serialized)
      * KCMC K and M parameters
      * */
-    auto *instance = new KCMC_Instance(argv[1]);
-    alt_k = argv[2];
-    std::transform(alt_k.begin(), alt_k.end(),alt_k.begin(), ::toupper);
-    char p[alt_k.size()];
-    strcpy(p, alt_k.c_str());
-    if (alt_k.find('K') != std::string::npos) {
-        k = ((int)p[2]) - ((int)'0');  // ONLY FOR K,M < 10!!!
-        m = ((int)p[4]) - ((int)'0');  // ONLY FOR K,M < 10!!!
-    } else {
+    auto *instance = KCMC_Instance::load(argv[1]);
+    if (not parse_km(argv[2], &k, &m)) {
+        if (argc < 4) { help(); }
         k = std::stoi(argv[2]);
         m = std::stoi(argv[3]);
     }
 
-    // Prepare the clock buffers
-    auto start = std::chrono::high_resolution_clock::now();
-    auto end = std::chrono::high_resolution_clock::now();
-    long duration;
-
-    // Print the header
-    // printf("Key\tK\tM\tOperation\tRuntime\tValid\tObjective\tCompression\tSolution\n");
-
-    // Validate the whole instance, getting the first local optima using DINIC Algorithm
-    set_used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    instance->local_optima(k, m, emptyset, &set_used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    printout_short(instance, k, m, instance->num_sensors,
-                   "dinic",
-                   duration, set_used_installation_spots);
-
-    // Process the Minimal-Flood mapping of the instance
-    used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    num_paths = instance->flood(k, m, false, emptyset, &used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    set_used_installation_spots.clear();
-    setify(set_used_installation_spots, &used_installation_spots);
-    printout_short(instance, k, m, instance->num_sensors,
-                   "min_flood_" + std::to_string(num_paths),  // Add the number of paths found
-                   duration, set_used_installation_spots);
-
-    // Process the Max-Flood mapping of the instance
-    used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    num_paths = instance->flood(k, m, true, emptyset, &used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    set_used_installation_spots.clear();
-    setify(set_used_installation_spots, &used_installation_spots);
-    printout_short(instance, k, m, instance->num_sensors,
-                   "max_flood_" + std::to_string(num_paths),  // Add the number of paths found
-                   duration, set_used_installation_spots);
-
-    // Process the No-Flood Reuse mapping of the instance
-    used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    num_paths = instance->reuse(k, m, 0,emptyset, &used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    set_used_installation_spots.clear();
-    setify(set_used_installation_spots, &used_installation_spots);
-    printout_short(instance, k, m, instance->num_sensors,
-                   "no_reuse_" + std::to_string(num_paths),  // Add the number of added sensors for k-coverage
-                   duration, set_used_installation_spots);
-
-    // Process the Min-Flood Reuse mapping of the instance
-    used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    num_paths = instance->reuse(k, m, 1,emptyset, &used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    set_used_installation_spots.clear();
-    setify(set_used_installation_spots, &used_installation_spots);
-    printout_short(instance, k, m, instance->num_sensors,
-                   "min_reuse_" + std::to_string(num_paths),  // Add the number of added sensors for k-coverage
-                   duration, set_used_installation_spots);
-
-    // Process the Max-Flood Reuse mapping of the instance
-    used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    num_paths = instance->reuse(k, m, -1,emptyset, &used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    set_used_installation_spots.clear();
-    setify(set_used_installation_spots, &used_installation_spots);
-    printout_short(instance, k, m, instance->num_sensors,
-                   "max_reuse_" + std::to_string(num_paths),  // Add the number of added sensors for k-coverage
-                   duration, set_used_installation_spots);
-
-    // Process the Best-Reuse mapping of the instance
-    used_installation_spots.clear();
-    start = std::chrono::high_resolution_clock::now();
-    num_paths = instance->reuse(k, m,emptyset, &used_installation_spots);
-    end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    set_used_installation_spots.clear();
-    setify(set_used_installation_spots, &used_installation_spots);
-    printout_short(instance, k, m, instance->num_sensors,
-                   "best_reuse_" + std::to_string(num_paths),  // Add the number of added sensors for k-coverage
-                   duration, set_used_installation_spots);
-
+    run_heuristics(instance, k, m);
     return 0;
 }
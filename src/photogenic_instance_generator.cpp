@@ -47,12 +47,12 @@ int main(int argc, char* const argv[]) {
     /* Prepare Buffers */
     bool must_break;
     int attempt, num_pois, num_sensors, num_sinks, area_side, coverage_radius, communication_radius, k, m,
-        MAX_TRIES=200000, invalid_count=0, compare_buffer[7], i, j, last_print, valid_cases, level_graph[10000],
-        algo_results[7][10000];
+        MAX_TRIES=200000, invalid_count=0, compare_buffer[7], i, j, last_print, valid_cases;
     long long random_seed;
     std::string name_map[7];
     std::unordered_set<int> emptyset, ignoredset, seed_sensors, set_dinic;
     std::unordered_map<int, int> used_installation_spots;
+    KCMC_Instance *instance = nullptr;  // Generated once, and then reseeded in place for each attempt
 
     /* Parse CMD SETTINGS */
     num_pois    = atoi(argv[1]);
@@ -70,6 +70,11 @@ int main(int argc, char* const argv[]) {
         random_seed = 100000000 + std::abs((rand() % 100000000)) + std::abs((rand() % 100000000));
     }
 
+    /* Per-sensor buffers, sized by the instance. The results of each algorithm are 0/1 per sensor */
+    std::vector<int> level_graph(num_sensors);
+    std::vector<std::vector<int>> algo_results(7, std::vector<int>(num_sensors));
+    std::vector<Placement> pl_pois(num_pois), pl_sensors(num_sensors), pl_sinks(num_sinks);
+
     /* ================== *
      * GENERATE INSTANCES *
      *
@@ -90,9 +95,10 @@ int main(int argc, char* const argv[]) {
     last_print = 0;
     for (attempt=0; attempt<MAX_TRIES; attempt++) {
         if (argc <= 9) { random_seed = random_seed + std::abs((rand() % 100000)) + 7 + attempt; }
-        auto *instance = new KCMC_Instance(num_pois, num_sensors, num_sinks,
-                                           area_side, coverage_radius, communication_radius,
-                                           random_seed);
+        if (instance == nullptr) {
+            instance = new KCMC_Instance(num_pois, num_sensors, num_sinks,
+                                         area_side, coverage_radius, communication_radius, random_seed);
+        } else {instance->reseed(random_seed);}
         valid_cases = attempt - invalid_count;
         if ((((attempt % 5000) == 0) or ((valid_cases % 50) == 0)) and (valid_cases != last_print)) {
             std::cout << "Attempt " << attempt << " (v" << valid_cases << ") Seed " << random_seed << std::endl;
@@ -198,8 +204,7 @@ int main(int argc, char* const argv[]) {
 
             /** DOT
             // Print the instance placements in DOT-compatible language
-            Placement pl_pois[num_pois], pl_sensors[num_sensors], pl_sinks[num_sinks];
-            instance->get_placements(pl_pois, pl_sensors, pl_sinks);
+            instance->get_placements(pl_pois.data(), pl_sensors.data(), pl_sinks.data());
 
             std::cout << "SINK [pos=\"" << pl_sinks[0].x << "," << pl_sinks[0].y << "!\"]" << std::endl;
             for (j=0; j<num_pois; j++) {std::cout << "POI_" << j << " [pos=\"" << pl_pois[j].x << "," << pl_pois[j].y << "!\"]" << std::endl;}
@@ -209,17 +214,17 @@ int main(int argc, char* const argv[]) {
             // Print the connections
             for (j=0; j<num_pois; j++) {
                 for (i=0; i<num_sensors; i++) {
-                    if (isin(instance->poi_sensor[j], i)) {std::cout << "POI_" << j << " -> i" << i << ';' << std::endl;}
+                    if (instance->poi_sensor.has(j, i)) {std::cout << "POI_" << j << " -> i" << i << ';' << std::endl;}
                 }
             }
             std::cout << std::endl;
             for (i=0; i<num_sensors; i++) {
-                if (isin(instance->sink_sensor[0], i)) {std::cout << "SINK -> i" << i << ';' << std::endl;}
+                if (instance->sink_sensor.has(0, i)) {std::cout << "SINK -> i" << i << ';' << std::endl;}
             }
             std::cout << std::endl;
             for (j=0; j<num_sensors; j++) {
                 for (i=j; i<num_sensors; i++) {
-                    if (isin(instance->sensor_sensor[j], i)) {std::cout << "i" << j << " -> i" << i << ';' << std::endl;}
+                    if (instance->sensor_sensor.has(j, i)) {std::cout << "i" << j << " -> i" << i << ';' << std::endl;}
                 }
             }
             std::cout << std::endl;
@@ -228,8 +233,7 @@ int main(int argc, char* const argv[]) {
             /** LATEX TIKZ
              *
              */
-            Placement pl_pois[num_pois], pl_sensors[num_sensors], pl_sinks[num_sinks];
-            instance->get_placements(pl_pois, pl_sensors, pl_sinks);
+            instance->get_placements(pl_pois.data(), pl_sensors.data(), pl_sinks.data());
 
             double scale = 10.7/area_side;
 
@@ -249,21 +253,21 @@ int main(int argc, char* const argv[]) {
             // Print the connections
             for (j=0; j<num_pois; j++) {
                 for (i=0; i<num_sensors; i++) {
-                    if (isin(instance->poi_sensor[j], i)) {
+                    if (instance->poi_sensor.has(j, i)) {
                         std::cout << "\\draw[dotted] (p" << j << ") -- (i" << i << ");" << std::endl;
                     }
                 }
             }
             std::cout << std::endl;
             for (i=0; i<num_sensors; i++) {
-                if (isin(instance->sink_sensor[0], i)) {
+                if (instance->sink_sensor.has(0, i)) {
                     std::cout << "\\draw (s0) -- (i" << i << ");" << std::endl;
                 }
             }
             std::cout << std::endl;
             for (j=0; j<num_sensors; j++) {
                 for (i=j; i<num_sensors; i++) {
-                    if (isin(instance->sensor_sensor[j], i)) {
+                    if (instance->sensor_sensor.has(j, i)) {
                         std::cout << "\\draw (i" << j << ") -- (i" << i << ");" << std::endl;
                     }
                 }
@@ -283,13 +287,15 @@ int main(int argc, char* const argv[]) {
             }
 
             // Print the level-graph
-            // instance->level_graph(level_graph, emptyset);
+            // instance->level_graph(level_graph.data(), emptyset);
             // for (i=0; i<num_sensors; i++) {std::cout << "SENSOR " << i << " LEVEL " << level_graph[i] << std::endl;}
 
+            delete instance;
             return (0);
         }
     }
 
     std::cout << "FAILURE AT " << MAX_TRIES << " TRIES!" << std::endl;
+    delete instance;
     return (1);
 }
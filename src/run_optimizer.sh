@@ -1,20 +1,13 @@
 #!/bin/sh
 
-# For adding quotes:
-# cat /data/instances.csv | sed 's/^ */ "/; s/ *$/" /; s/ *| */"| "/g' >> /tmp/data.csv
-# For direct copy
-# cat /data/instances.csv >> /tmp/data.csv
-# Replace pipe by tab
-# sed -i 's/| /\t/g' /tmp/data.csv
+# The optimizer reads the instances CSV lines (instance | (KxMy)) directly in batch mode, so there is no need to filter
+# the lines or to pass the instances as arguments
 
-# Filter lines with python, to avoid too-long-command-lines
-rm -f /tmp/data.csv
-cat /data/instances.csv | python3 -c 'import sys; [print((";".join(line.split(";", 4)[:4]))+";END\t"+(line.split("|")[-1]).strip()) for line in sys.stdin]' >> /tmp/data.csv
-
-# Process in parallel
-rm -f /tmp/*.par
-parallel -a /tmp/data.csv --colsep '\t' --files /app/optimizer
-
-# Store results
+# Process in parallel, streaming one block of lines through a single optimizer process for each job slot
+# Without GNU parallel, a single optimizer process reads the whole file, with the same output
 rm -f /results/optimizer.csv
-cat /tmp/*.par > /results/optimizer.csv
+if command -v parallel > /dev/null; then
+    parallel --pipepart -a /data/instances.csv --block -1 --keep-order /app/optimizer --batch - > /results/optimizer.csv
+else
+    /app/optimizer --batch /data/instances.csv > /results/optimizer.csv
+fi
@@ -0,0 +1,136 @@
+/** WORK_STEALING_POOL.cpp
+ * Implementation of the pool of long-lived worker threads, each with its own deque of tasks, that steal from each other
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::max
+#include <utility>    // move
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* The pool and the index of the worker running on this thread, if any */
+thread_local WorkStealingPool *WorkStealingPool::current_pool = nullptr;
+thread_local int WorkStealingPool::current_worker = -1;
+
+
+/* #####################################################################################################################
+ * POOL LIFETIME
+ */
+
+WorkStealingPool::WorkStealingPool(const int num_workers) {
+    int worker, workers = std::max(1, num_workers);
+    for (worker=0; worker<workers; worker++) {this->deques.emplace_back(new TaskDeque());}
+    for (worker=0; worker<workers; worker++) {this->workers.emplace_back(&WorkStealingPool::work, this, worker);}
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> state(this->state_lock);
+        this->all_done.wait(state, [this]() {return (this->queued == 0) and (this->running == 0);});
+        this->stopping = true;
+    }
+    this->work_ready.notify_all();
+    for (std::thread &worker : this->workers) {worker.join();}
+}
+
+
+/* #####################################################################################################################
+ * TASKS
+ */
+
+/** SUBMIT
+ * Pushes the task to the back of the deque of the worker running the caller, or of the next deque in turn if the
+ * caller is not a worker of this pool. It is counted while its deque is still locked, so it is never taken uncounted.
+ * The state lock is only ever taken inside a deque lock, never the other way around
+ */
+void WorkStealingPool::submit(std::function<void()> task) {
+    int worker = (current_pool == this) ? current_worker : -1;
+    if (worker < 0) {
+        std::lock_guard<std::mutex> state(this->state_lock);
+        worker = this->next_deque;
+        this->next_deque = (this->next_deque + 1) % (int)this->deques.size();
+    }
+    {
+        std::lock_guard<std::mutex> guard(this->deques[worker]->lock);
+        this->deques[worker]->tasks.push_back(std::move(task));
+        std::lock_guard<std::mutex> state(this->state_lock);
+        this->queued++;
+    }
+    this->work_ready.notify_one();
+}
+
+
+/** WAIT
+ * Blocks until no task is queued or running, and rethrows the first exception of the finished tasks, if any
+ */
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> state(this->state_lock);
+    this->all_done.wait(state, [this]() {return (this->queued == 0) and (this->running == 0);});
+    if (this->error) {
+        std::exception_ptr first_error = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(first_error);
+    }
+}
+
+
+/** TAKE
+ * Pops the newest task of the worker's own deque, or else steals the oldest task of the next non-empty deque.
+ * The task moves from the queued to the running count while its deque is still locked, so a worker that saw it
+ * counted and finds its deque empty afterwards sees the updated count too, and the pool is never seen idle in between
+ */
+bool WorkStealingPool::take(const int worker, std::function<void()> &task) {
+    int size = (int)this->deques.size();
+    for (int offset=0; offset<size; offset++) {
+        TaskDeque &deque = *this->deques[(worker + offset) % size];
+        std::lock_guard<std::mutex> guard(deque.lock);
+        if (deque.tasks.empty()) {continue;}
+        if (offset == 0) {
+            task = std::move(deque.tasks.back());
+            deque.tasks.pop_back();
+        } else {
+            task = std::move(deque.tasks.front());
+            deque.tasks.pop_front();
+        }
+        std::lock_guard<std::mutex> state(this->state_lock);
+        this->queued--;
+        this->running++;
+        return true;
+    }
+    return false;
+}
+
+
+/** WORKER LOOP
+ * Takes a task from the deques (its own first) and runs it. When there is none, sleeps until a task is queued, or
+ * returns once the pool stops. A worker only scans the deques again after seeing a queued task, which is then either
+ * still in a deque or already taken by another worker, so there is no busy waiting
+ */
+void WorkStealingPool::work(const int worker) {
+    std::function<void()> task;
+    current_pool = this;
+    current_worker = worker;
+    while (true) {
+        if (not this->take(worker, task)) {
+            std::unique_lock<std::mutex> state(this->state_lock);
+            this->work_ready.wait(state, [this]() {return this->stopping or (this->queued > 0);});
+            if (this->queued == 0) {return;}
+            continue;
+        }
+
+        try {task();}
+        catch (...) {
+            std::lock_guard<std::mutex> state(this->state_lock);
+            if (not this->error) {this->error = std::current_exception();}
+        }
+        task = nullptr;
+
+        std::lock_guard<std::mutex> state(this->state_lock);
+        this->running--;
+        if ((this->queued == 0) and (this->running == 0)) {this->all_done.notify_all();}
+    }
+}
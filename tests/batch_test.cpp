@@ -0,0 +1,171 @@
+/** BATCH_TEST.cpp
+ * Checks the batch mode of the optimizer against one optimizer process per line, as the deployment ran it, on the
+ * given instances CSV. The outputs must match, apart from the runtime column, for the CSV as is (instance and pair
+ * split at the last '|'), for the same lines split by a TAB and read from STDIN, for an instance file with a '|' in
+ * its name, for a file repeating and alternating instances (reused while consecutive), and for a file with bad lines,
+ * each reported on STDERR with its line number.
+ * Every batch also runs scheduled on three threads
+ * Usage: batch_test <optimizer> <instances CSV>
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <cstdio>     // popen, pclose, fread
+#include <fstream>    // ifstream, ofstream
+#include <iostream>   // cout, cerr, endl
+#include <sstream>    // ostringstream, istringstream
+#include <string>     // string, getline
+#include <vector>     // vector
+
+
+/* Runs the shell command. Returns its STDOUT */
+static std::string run(const std::string &command) {
+    std::string output;
+    char buffer[4096];
+    size_t read;
+    FILE *pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {return "";}
+    while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {output.append(buffer, read);}
+    pclose(pipe);
+    return output;
+}
+
+
+/* Returns the content of the file */
+static std::string read_file(const std::string &file_name) {
+    std::ifstream file(file_name);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+
+/* Returns the argument quoted for the shell (instances hold no single quotes) */
+static std::string quoted(const std::string &argument) {return "'" + argument + "'";}
+
+
+/* Returns the output without its runtime column (the fifth), which differs from run to run */
+static std::string without_runtime(const std::string &output) {
+    std::istringstream lines(output);
+    std::string line, result;
+    while (std::getline(lines, line)) {
+        size_t begin = 0;
+        for (int column=0; (column < 4) and (begin != std::string::npos); column++) {
+            begin = line.find('\t', begin);
+            if (begin != std::string::npos) {begin++;}
+        }
+        size_t end = (begin == std::string::npos) ? std::string::npos : line.find('\t', begin);
+        if (end != std::string::npos) {line.erase(begin, end - begin + 1);}
+        result += line + "\n";
+    }
+    return result;
+}
+
+
+/* Splits the CSV line at its last '|' in the instance and the pair, trimmed */
+static void split_line(const std::string &line, std::string *source, std::string *pair) {
+    size_t split_at = line.rfind('|');
+    *source = line.substr(0, split_at);
+    *pair = line.substr(split_at + 1);
+    source->erase(source->find_last_not_of(' ') + 1);
+    pair->erase(0, pair->find_first_not_of(' '));
+    pair->erase(pair->find_last_not_of(" \r") + 1);
+}
+
+
+/* Runs the optimizer on the batch file, serially and scheduled on three threads, and compares both with the expected
+ * output and STDERR. Returns if they all match
+ */
+static bool check_batch(const std::string &optimizer, const std::string &name, const std::string &input,
+                        const std::string &expected, const std::string &expected_errors) {
+    bool ok = true;
+    for (const char *threads : {"1", "3"}) {
+        std::string output = run("KCMC_THREADS=" + std::string(threads) + " " + quoted(optimizer) + " --batch "
+                                 + input + " 2> batch_test.err");
+        std::string errors = read_file("batch_test.err");
+        bool same = (without_runtime(output) == expected) and (errors == expected_errors);
+        std::cout << name << " (threads " << threads << ")\t" << (same ? "OK" : "MISMATCH") << std::endl;
+        if (not same) {std::cerr << errors;}
+        ok = ok and same;
+    }
+    return ok;
+}
+
+
+int main(int argc, char* const argv[]) {
+    if (argc < 3) {
+        std::cerr << "USAGE: batch_test <optimizer> <instances CSV>" << std::endl;
+        return 1;
+    }
+    const std::string optimizer(argv[1]), csv(argv[2]);
+    std::string line, source, pair;
+    std::vector<std::string> sources, pairs, per_line;
+    bool ok = true;
+
+    // One optimizer process per line, with the instance in the arguments
+    std::ifstream file(csv);
+    while (std::getline(file, line)) {
+        if (line.find('|') == std::string::npos) {continue;}
+        split_line(line, &source, &pair);
+        sources.push_back(source);
+        pairs.push_back(pair);
+        per_line.push_back(without_runtime(run(quoted(optimizer) + " " + quoted(source) + " " + quoted(pair)
+                                               + " 2> /dev/null")));
+    }
+    if (sources.size() < 2) {
+        std::cerr << "UNABLE TO READ THE INSTANCES CSV " << csv << std::endl;
+        return 1;
+    }
+    std::string expected;
+    for (const std::string &output : per_line) {expected += output;}
+
+    // The CSV as is, and split by TABs from STDIN
+    ok = check_batch(optimizer, "csv", quoted(csv), expected, "") and ok;
+    std::ofstream tab_file("batch_test.tab.csv");
+    for (size_t i=0; i < sources.size(); i++) {tab_file << sources[i] << "\t" << pairs[i] << "\n";}
+    tab_file.close();
+    ok = check_batch(optimizer, "tab stdin", "- < batch_test.tab.csv", expected, "") and ok;
+
+    // An instance file with a '|' in its name, split at the last '|', and by a TAB before any '|'
+    std::ofstream instance_file("batch_test|instance.txt");
+    instance_file << sources[0] << "\n";
+    instance_file.close();
+    std::ofstream pipe_file("batch_test.pipe.csv");
+    pipe_file << "batch_test|instance.txt | " << pairs[0] << "\n" << "batch_test|instance.txt\t" << pairs[0] << "\n";
+    pipe_file.close();
+    ok = check_batch(optimizer, "pipe in name", "batch_test.pipe.csv", per_line[0] + per_line[0], "") and ok;
+
+    // Repeated instances, loaded once while consecutive, with other pairs, and coming back after another instance
+    const std::string reuse_pairs[5] = {pairs[0], "(K2M2)", "(K1M1)", pairs[1], "(K2M1)"};
+    const int reuse_sources[5] = {0, 0, 0, 1, 0};
+    std::ofstream reuse_file("batch_test.reuse.csv");
+    expected.clear();
+    for (int i=0; i<5; i++) {
+        source = sources[reuse_sources[i]];
+        reuse_file << source << " | " << reuse_pairs[i] << "\n";
+        expected += without_runtime(run(quoted(optimizer) + " " + quoted(source) + " " + quoted(reuse_pairs[i])
+                                        + " 2> /dev/null"));
+    }
+    reuse_file.close();
+    ok = check_batch(optimizer, "reuse", "batch_test.reuse.csv", expected, "") and ok;
+
+    // Bad lines: no pair, a bad pair, a blank line (skipped), a bad instance, and a pair the instance cannot cover
+    std::ofstream bad_file("batch_test.bad.csv");
+    bad_file << sources[0] << " | " << pairs[0] << "\n"
+             << "KCMC;no pair\n"
+             << sources[0] << " | (KxMy)\n"
+             << "\n"
+             << "KCMC;not an instance | (K1M1)\n"
+             << sources[1] << "\t(K60M1)\n"
+             << sources[1] << "\t" << pairs[1] << "\n";
+    bad_file.close();
+    const std::string bad_errors = "LINE 2: MISSING (K{k}M{m}) PAIR\n"
+                                   "LINE 3: INVALID (K{k}M{m}) PAIR  (KxMy)\n"  // The pair as written
+                                   "LINE 5: INVALID INTEGER IN INSTANCE!\n"
+                                   "LINE 6: INVALID INSTANCE! (INSUFFICIENT COVERAGE)\n";
+    ok = check_batch(optimizer, "bad lines", "batch_test.bad.csv", per_line[0] + per_line[1], bad_errors) and ok;
+
+    if (not ok) {std::cerr << "BATCH OUTPUT DIFFERS FROM ONE PROCESS PER LINE" << std::endl;}
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+/** BINARY_FORMAT_TEST.cpp
+ * Checks that a binary instance loads back as written, and that files of the right size with corrupt CSR arrays
+ * (decreasing offsets, a wrong last offset, a neighbor out of range or out of order) are rejected on load
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <cstdio>     // remove
+#include <cstring>    // memcpy
+#include <fstream>    // ifstream, ofstream
+#include <iostream>   // cout, cerr, endl
+#include <iterator>   // istreambuf_iterator
+#include <memory>     // unique_ptr
+#include <string>     // string
+#include <vector>     // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* Writes the bytes, with the int at the given index (in ints after the header) replaced, and tries to load them.
+ * Returns if the load was rejected
+ */
+static bool rejected(const std::string &bytes, const size_t index, const int value, const std::string &path) {
+    std::string corrupt = bytes;
+    memcpy(&corrupt[sizeof(KCMC_BinaryHeader) + sizeof(int) * index], &value, sizeof(int));
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupt;
+    try {
+        std::unique_ptr<KCMC_Instance> instance(KCMC_Instance::load(path));
+    } catch (const std::exception &exc) {return true;}
+    return false;
+}
+
+
+int main() {
+    bool ok = true;
+    const std::string path = "binary_format_test.kcmcb";
+    KCMC_Instance original(100, 300, 1, 300, 50, 100, 263183180);
+    original.write_binary(path);
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // The file as written loads back to the same instance
+    {
+        std::unique_ptr<KCMC_Instance> loaded(KCMC_Instance::load(path));
+        ok = (loaded->serialize() == original.serialize()) and ok;
+        std::cout << "round trip\t" << (ok ? "OK" : "MISMATCH") << std::endl;
+    }
+
+    // Corrupt arrays of poi_sensor (the first adjacency in the file): offsets, then neighbors
+    size_t pois = original.num_pois, neighbors = pois + 1, row = 0;
+    int edges = original.poi_sensor.num_edges();
+    while (original.poi_sensor.degree(row) < 2) {row++;}  // A row with two neighbors, to repeat the first one
+    size_t second = neighbors + original.poi_sensor.offsets()[row] + 1;
+    struct {const char *name; size_t index; int value;} corruptions[] = {
+        {"first offset", 0, 1},
+        {"decreasing offset", 1, -1},
+        {"offset past the edges", 1, edges + 1},
+        {"last offset", pois, edges - 1},
+        {"negative neighbor", neighbors, -1},
+        {"neighbor out of range", neighbors, original.num_sensors},
+        {"repeated neighbor", second, *original.poi_sensor[row].begin()}
+    };
+    for (const auto &corruption : corruptions) {
+        bool is_rejected = rejected(bytes, corruption.index, corruption.value, path);
+        std::cout << corruption.name << "\t" << (is_rejected ? "REJECTED" : "ACCEPTED") << std::endl;
+        ok = is_rejected and ok;
+    }
+
+    remove(path.c_str());
+    if (not ok) {std::cerr << "BINARY INSTANCE CHECKS FAILED" << std::endl;}
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/** BUCKET_QUEUE_TEST.cpp
+ * Checks the pop order of the bucket queue against a heap of LevelNodes with CompareLevelNode, along random sequences
+ * of pushes, pops, drains and clears. The keys are spread around first keys anywhere in the int range (negative keys
+ * and both ends included), narrowly to stay in the window, or widely to spill into the heaps below and above it. The
+ * queue is drained now and then, so the window is placed again around a new first key
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::min, std::max
+#include <climits>    // INT_MIN, INT_MAX
+#include <iostream>   // cout, cerr, endl
+#include <queue>      // priority_queue
+#include <random>     // mt19937
+#include <vector>     // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+typedef std::priority_queue<LevelNode, std::vector<LevelNode>, CompareLevelNode> ReferenceQueue;
+
+
+/* Returns a random key at most spread away from the center, clamped into the int range */
+static int random_key(const long long center, const int spread, std::mt19937 &generator) {
+    long long key = center + (long long)(generator() % (2 * (unsigned)spread + 1)) - spread;
+    return (int)std::min(std::max(key, (long long)INT_MIN), (long long)INT_MAX);
+}
+
+
+/* Runs a random sequence of operations on both queues. Returns the number of mismatches. Counts the pushes far out of
+ * the window (more than a window away from the first key since the queue was last empty), which must have spilled
+ */
+static int check_sequence(const long long center, const int spread, std::mt19937 &generator,
+                          int *far_below, int *far_above) {
+    BucketQueue queue;
+    ReferenceQueue reference;
+    int mismatches = 0, next_index = 0, key, operation;
+    long long first_key = 0;
+
+    for (int step=0; step<4000; step++) {
+        mismatches += (queue.empty() != reference.empty()) ? 1 : 0;
+        operation = (int)(generator() % 100);
+
+        if ((operation < 2) or ((operation < 4) and not reference.empty())) {
+            // Clear, or drain, so the window is placed again
+            if (operation < 2) {
+                queue.clear();
+                reference = ReferenceQueue();
+            }
+            while (not reference.empty()) {
+                mismatches += (queue.empty() or (queue.pop() != reference.top().index)) ? 1 : 0;
+                reference.pop();
+            }
+            mismatches += queue.empty() ? 0 : 1;
+        } else if ((operation < 60) or reference.empty()) {
+            // Push a new index (indices are unique, as in a search), with a few equal keys
+            key = (operation % 7 == 0) ? random_key(center, 2, generator) : random_key(center, spread, generator);
+            if (reference.empty()) {first_key = key;}
+            *far_below += ((long long)key < first_key - 256) ? 1 : 0;
+            *far_above += ((long long)key > first_key + 256) ? 1 : 0;
+            queue.push(next_index, key);
+            reference.push({next_index, key});
+            next_index++;
+        } else {
+            mismatches += (queue.pop() != reference.top().index) ? 1 : 0;
+            reference.pop();
+        }
+    }
+    return mismatches;
+}
+
+
+int main() {
+    std::mt19937 generator(11);
+    int mismatches = 0, sequences = 0, far_below = 0, far_above = 0;
+    const long long centers[7] = {0, 5, -3, -100000, 1 << 24, INT_MIN, INT_MAX};
+    const int spreads[4] = {3, 100, 300, 5000};
+
+    for (const long long &center : centers) {
+        for (const int &spread : spreads) {
+            for (int repeat=0; repeat<3; repeat++) {
+                mismatches += check_sequence(center, spread, generator, &far_below, &far_above);
+                sequences++;
+            }
+        }
+    }
+
+    std::cout << "bucket queue\t" << ((mismatches == 0) ? "OK" : "MISMATCH") << "\t" << sequences << " sequences, "
+              << far_below << " pushes far below and " << far_above << " far above the window" << std::endl;
+    if ((far_below == 0) or (far_above == 0)) {std::cerr << "THE SPILL HEAPS WERE NOT EXERCISED" << std::endl;}
+    if (mismatches != 0) {std::cerr << "BUCKET QUEUE ORDER DIFFERS FROM THE LEVEL NODE HEAP" << std::endl;}
+    return ((mismatches == 0) and (far_below > 0) and (far_above > 0)) ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/** CERTIFICATE_TEST.cpp
+ * Checks the certified connectivity services against fresh evaluations, in greedy and exact modes, along random
+ * sequences of sensor deactivations (with a few reactivations and larger jumps). Each service keeps its certificate
+ * along the whole sequence, and must report the same connectivity and validity as a fresh call. Greedy votes must be
+ * the same too, while kept exact paths may cross other sensors than fresh ones, so their votes must only be active
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <iostream>       // cout, cerr, endl
+#include <random>         // mt19937
+#include <unordered_map>  // unordered_map
+#include <vector>         // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* Runs a deactivation sequence on the instance with the current connectivity method. Returns the number of
+ * mismatches with the fresh evaluations
+ */
+static int check_sequence(KCMC_Instance &instance, std::mt19937 &generator) {
+    int mismatches = 0, a_sensor, step, flip, target;
+    ConnectivityCertificate connectivity_certificate, check_certificate, validate_certificate;
+    SensorSet inactive_sensors(instance.num_sensors);
+    std::vector<int> certified(instance.num_pois), fresh(instance.num_pois);
+    std::unordered_map<int, int> certified_votes, fresh_votes;
+
+    for (step=0; step<200; step++) {
+        for (flip=0; flip < ((step % 50 == 49) ? 40 : 1 + (int)(generator() % 3)); flip++) {
+            a_sensor = (int)(generator() % instance.num_sensors);
+            if (generator() % 8 == 0) {inactive_sensors.erase(a_sensor);}
+            else {inactive_sensors.insert(a_sensor);}
+        }
+
+        // Connectivity of every POI, with a target that grows along the sequence
+        target = 1 + (step / 70);
+        mismatches += (instance.get_connectivity(certified.data(), inactive_sensors, target, &connectivity_certificate)
+                       != instance.get_connectivity(fresh.data(), inactive_sensors, target)) ? 1 : 0;
+        mismatches += (certified != fresh) ? 1 : 0;
+
+        // M-connectivity up to the first failure, with its votes
+        mismatches += (instance.fast_m_connectivity(2, inactive_sensors, &certified_votes, &check_certificate)
+                       != instance.fast_m_connectivity(2, inactive_sensors, &fresh_votes)) ? 1 : 0;
+        if (KCMC_Instance::connectivity_method == CONN_EXACT) {
+            for (const auto &vote : certified_votes) {mismatches += inactive_sensors.contains(vote.first) ? 1 : 0;}
+        } else {
+            mismatches += (certified_votes != fresh_votes) ? 1 : 0;
+        }
+
+        // Validation
+        mismatches += (instance.validate(false, 1, 2, inactive_sensors, &validate_certificate)
+                       != instance.validate(false, 1, 2, inactive_sensors)) ? 1 : 0;
+    }
+    return mismatches;
+}
+
+
+int main() {
+    std::mt19937 generator(7);
+    int mismatches = 0;
+    const int methods[2] = {CONN_GREEDY, CONN_EXACT};
+    const char *names[2] = {"greedy", "exact"};
+
+    for (int method=0; method<2; method++) {
+        int method_mismatches = 0;
+        KCMC_Instance::connectivity_method = methods[method];
+        for (long long seed=1; seed <= 4; seed++) {
+            KCMC_Instance instance(150, 250, 2, 250, 45, 55, seed);
+            method_mismatches += check_sequence(instance, generator);
+        }
+        std::cout << names[method] << "\t" << ((method_mismatches == 0) ? "OK" : "MISMATCH") << "\t"
+                  << method_mismatches << std::endl;
+        mismatches += method_mismatches;
+    }
+
+    if (mismatches != 0) {std::cerr << "CERTIFIED CONNECTIVITY DIFFERS FROM A FRESH EVALUATION" << std::endl;}
+    return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/** LEVEL_GRAPH_TEST.cpp
+ * Checks the dynamic level graph against a fresh KCMC_Instance::level_graph after every random toggle and sync, on
+ * random instances. The syncs change a few sensors (toggled one by one), exactly a sixteenth of them (the most that
+ * is still toggled), one more than that (rebuilt), or a fifth of them
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::shuffle
+#include <iostream>   // cout, cerr, endl
+#include <numeric>    // std::iota
+#include <random>     // mt19937
+#include <vector>     // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* Returns if the levels, the max level and the inactive sensors of the level graph match a fresh level_graph */
+static bool matches(KCMC_Instance &instance, const LevelGraph &levels, const SensorSet &inactive_sensors) {
+    std::vector<int> expected(instance.num_sensors);
+    int max_level = instance.level_graph(expected.data(), inactive_sensors);
+    bool same = (max_level == levels.max_level()) and (levels.inactive_sensors().words == inactive_sensors.words);
+    for (int i=0; i < instance.num_sensors; i++) {same = same and (levels[i] == expected[i]);}
+    return same;
+}
+
+
+/* Toggles the given number of random sensors of the set */
+static void toggle_random(SensorSet &inactive_sensors, const int count, std::mt19937 &generator) {
+    std::vector<int> sensors(inactive_sensors.size());
+    std::iota(sensors.begin(), sensors.end(), 0);
+    std::shuffle(sensors.begin(), sensors.end(), generator);
+    for (int i=0; i<count; i++) {
+        if (inactive_sensors.contains(sensors[i])) {inactive_sensors.erase(sensors[i]);}
+        else {inactive_sensors.insert(sensors[i]);}
+    }
+}
+
+
+int main() {
+    std::mt19937 generator(5);
+    int mismatches = 0, checks = 0, a_sensor, step;
+
+    for (int trial=0; trial<30; trial++) {
+        int num_sensors = 20 + (int)(generator() % 600);
+        KCMC_Instance instance(10, num_sensors, 1 + (int)(generator() % 3), 1000, 100, 80 + (int)(generator() % 150),
+                               generator());
+        LevelGraph levels(&instance);
+        SensorSet inactive_sensors(num_sensors);
+
+        for (step=0; step<400; step++) {
+            if (step % 50 == 49) {
+                const int sixteenth = num_sensors / 16;
+                const int counts[4] = {1 + (int)(generator() % 3), sixteenth, sixteenth + 1, num_sensors / 5};
+                toggle_random(inactive_sensors, counts[(step / 50) % 4], generator);
+                levels.sync(inactive_sensors);
+            } else {
+                a_sensor = (int)(generator() % num_sensors);
+                if (inactive_sensors.contains(a_sensor)) {inactive_sensors.erase(a_sensor); levels.activate(a_sensor);}
+                else {inactive_sensors.insert(a_sensor); levels.deactivate(a_sensor);}
+            }
+            mismatches += matches(instance, levels, inactive_sensors) ? 0 : 1;
+            checks++;
+        }
+    }
+
+    std::cout << "level graph\t" << ((mismatches == 0) ? "OK" : "MISMATCH") << "\t" << mismatches << " of " << checks
+              << " checks differ" << std::endl;
+    if (mismatches != 0) {std::cerr << "DYNAMIC LEVELS DIFFER FROM A FRESH LEVEL GRAPH" << std::endl;}
+    return (mismatches == 0) ? 0 : 1;
+}
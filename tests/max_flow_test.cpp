@@ -0,0 +1,121 @@
+/** MAX_FLOW_TEST.cpp
+ * Checks the exact node-disjoint paths engine against an Edmonds-Karp count on a dense node-split network, built from
+ * scratch for each POI, over small random instances with random inactive sensors. The same flow network is reused
+ * for every POI, in two orders and with a limit, to check that restoring the residual network leaves it reusable
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <algorithm>  // std::min, std::sort, std::unique
+#include <iostream>   // cout, cerr, endl
+#include <random>     // mt19937, bernoulli_distribution
+#include <vector>     // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* Reference number of node-disjoint paths from the active covering sensors of the POI to any sink, by Edmonds-Karp
+ * (BFS augmenting paths) on a capacity matrix. Sensor i is split in nodes 2i and 2i+1, as in the engine
+ */
+static int reference_paths(const KCMC_Instance &instance, const int poi, const SensorSet &inactive_sensors) {
+    const int n = instance.num_sensors, source = 2 * n, sink = 2 * n + 1, size = 2 * n + 2;
+    std::vector<std::vector<int>> capacity(size, std::vector<int>(size, 0));
+    for (int i=0; i<n; i++) {
+        if (inactive_sensors.contains(i)) {continue;}
+        capacity[2*i][2*i + 1] = 1;
+        for (const int &neighbor : instance.sensor_sensor[i]) {capacity[2*i + 1][2*neighbor] = 1;}
+        if (not instance.sensor_sink[i].empty()) {capacity[2*i + 1][sink] = 1;}
+    }
+    for (const int &a_sensor : instance.poi_sensor[poi]) {capacity[source][2*a_sensor] = 1;}
+
+    int flow = 0;
+    std::vector<int> parent(size), queue;
+    while (true) {
+        std::fill(parent.begin(), parent.end(), -1);
+        parent[source] = source;
+        queue.assign(1, source);
+        for (int head=0; (head < (int)queue.size()) and (parent[sink] == -1); head++) {
+            for (int next=0; next<size; next++) {
+                if ((parent[next] == -1) and (capacity[queue[head]][next] > 0)) {
+                    parent[next] = queue[head];
+                    queue.push_back(next);
+                }
+            }
+        }
+        if (parent[sink] == -1) {return flow;}
+        for (int node=sink; node != source; node = parent[node]) {
+            capacity[parent[node]][node]--;
+            capacity[node][parent[node]]++;
+        }
+        flow++;
+    }
+}
+
+
+/* Runs the engine on every POI of the given order, on the same network. Returns the number of mismatches */
+static int check_order(const KCMC_Instance &instance, DisjointPathsFlow &flow, const SensorSet &inactive_sensors,
+                       const std::vector<int> &expected, const std::vector<int> &order, const int limit) {
+    int mismatches = 0, paths;
+    std::vector<int> used_sensors;
+    for (const int &poi : order) {
+        used_sensors.clear();
+        paths = flow.max_paths(instance.poi_sensor[poi], limit, &used_sensors);
+        std::sort(used_sensors.begin(), used_sensors.end());
+        bool valid = (std::unique(used_sensors.begin(), used_sensors.end()) == used_sensors.end())
+                     and ((int)used_sensors.size() >= paths);
+        for (const int &a_sensor : used_sensors) {valid = valid and (not inactive_sensors.contains(a_sensor));}
+        if ((paths != std::min(expected[poi], limit)) or (not valid)) {mismatches++;}
+    }
+    return mismatches;
+}
+
+
+/* Checks every POI of the instance, for a few random sets of inactive sensors. Returns if they all match */
+static bool check_instance(const int num_pois, const int num_sensors, const int num_sinks, const int area_side,
+                           const int coverage_radius, const int communication_radius, const long long seed) {
+    KCMC_Instance instance(num_pois, num_sensors, num_sinks, area_side, coverage_radius, communication_radius, seed);
+    std::mt19937 generator((unsigned)seed);
+    DisjointPathsFlow flow;
+    flow.build(instance.num_sensors, instance.sensor_sensor, instance.sensor_sink);
+
+    int mismatches = 0, total = 0;
+    std::vector<int> expected(num_pois), forward(num_pois), backward(num_pois), buffer(num_pois);
+    for (int poi=0; poi<num_pois; poi++) {forward[poi] = poi; backward[poi] = num_pois - 1 - poi;}
+    for (const double &fraction : {0.0, 0.2, 0.5}) {
+        std::bernoulli_distribution inactive(fraction);
+        SensorSet inactive_sensors(num_sensors);
+        for (int i=0; i<num_sensors; i++) {if (inactive(generator)) {inactive_sensors.insert(i);}}
+        for (int poi=0; poi<num_pois; poi++) {
+            expected[poi] = reference_paths(instance, poi, inactive_sensors);
+            total += expected[poi];
+        }
+
+        // The same network for every POI, in both orders, and then with a limit
+        flow.set_inactive(inactive_sensors);
+        mismatches += check_order(instance, flow, inactive_sensors, expected, forward, num_sensors);
+        mismatches += check_order(instance, flow, inactive_sensors, expected, backward, num_sensors);
+        mismatches += check_order(instance, flow, inactive_sensors, expected, forward, 2);
+
+        // The instance service, whose leased networks are reused across the sets of inactive sensors
+        instance.exact_connectivity(buffer.data(), inactive_sensors, 3);
+        for (int poi=0; poi<num_pois; poi++) {mismatches += (buffer[poi] != std::min(expected[poi], 3)) ? 1 : 0;}
+    }
+
+    std::cout << instance.key() << "\t" << ((mismatches == 0) ? "OK" : "MISMATCH") << "\t" << total << " paths"
+              << std::endl;
+    return mismatches == 0;
+}
+
+
+int main() {
+    bool ok = true;
+    for (long long seed=1; seed <= 20; seed++) {
+        ok = check_instance(15, 40 + (int)(seed % 5) * 10, 1 + (int)(seed % 3), 200, 50, 60, seed) and ok;
+    }
+    ok = check_instance(30, 120, 2, 300, 60, 70, 263183180) and ok;
+
+    if (not ok) {std::cerr << "EXACT PATHS DIFFER FROM THE EDMONDS-KARP COUNT" << std::endl;}
+    return ok ? 0 : 1;
+}
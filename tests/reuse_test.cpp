@@ -0,0 +1,64 @@
+/** REUSE_TEST.cpp
+ * Checks the best reuse, whose variations run at once on a pool, against the three reuse variations run one after the
+ * other and compared with the same tie-break (fewest sensors, preferring max-flood, then no-flood). The chosen
+ * variation, its added sensors and its visited sensors must match, and so must the best reuse of a heuristic session
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <iostream>       // cout, cerr, endl
+#include <stdexcept>      // exception
+#include <unordered_map>  // unordered_map
+#include <vector>         // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* Runs the best reuse of the instance for the K and M in every way. Returns if they all match. Counts the ties */
+static bool check_reuse(KCMC_Instance &instance, const int k, const int m, int *ties) {
+    const int flood_levels[3] = {-1, 0, 1};
+    int added[3], used[3], best, variant;
+    std::unordered_map<int, int> visited[3], parallel, session_visited;
+    SensorSet inactive_sensors(instance.num_sensors);
+
+    // Serial, one variation after the other
+    try {
+        for (variant=0; variant<3; variant++) {
+            added[variant] = instance.reuse(k, m, flood_levels[variant], inactive_sensors, &visited[variant]);
+            used[variant] = (int)(visited[variant].size());
+        }
+    } catch (const std::exception &) {return true;}  // Not a k-m instance, as checked by the optimizer itself
+    best = 0;
+    for (variant=1; variant<3; variant++) {if (used[variant] < used[best]) {best = variant;}}
+    for (variant=0; variant<3; variant++) {*ties += ((variant != best) and (used[variant] == used[best])) ? 1 : 0;}
+
+    // Parallel, on the variant pool, and in a session
+    int parallel_added = instance.reuse(k, m, inactive_sensors, &parallel);
+    HeuristicSession session(&instance, k, m, inactive_sensors);
+    int session_added = session.reuse(&session_visited);
+
+    bool same = (parallel_added == added[best]) and (parallel == visited[best])
+                and (session_added == added[best]) and (session_visited == visited[best]);
+    if (not same) {std::cerr << instance.key() << " K" << k << "M" << m << " BEST REUSE DIFFERS" << std::endl;}
+    return same;
+}
+
+
+int main() {
+    bool ok = true;
+    int ties = 0, runs = 0;
+
+    for (long long seed=1; seed <= 12; seed++) {
+        KCMC_Instance instance(50, 200 + (int)(seed % 4) * 50, 1 + (int)(seed % 2), 400, 60, 80, seed);
+        for (const int &km : {11, 21, 22, 32, 33}) {
+            ok = check_reuse(instance, km / 10, km % 10, &ties) and ok;
+            runs++;
+        }
+    }
+
+    std::cout << "best reuse\t" << (ok ? "OK" : "MISMATCH") << "\t" << runs << " runs, " << ties << " ties"
+              << std::endl;
+    return ok ? 0 : 1;
+}
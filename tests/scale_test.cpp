@@ -0,0 +1,39 @@
+/** SCALE_TEST.cpp
+ * End-to-end check of a generated instance with a million sensors: it must be built (streamed from the spatial grids)
+ * and pass K1M1 in the memory limit set by its CTest target (ulimit -v, where available), reporting 64-bit path totals
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <chrono>         // steady_clock
+#include <iostream>       // cout, cerr, endl
+#include <unordered_map>  // unordered_map
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+int main() {
+    auto start = std::chrono::steady_clock::now();
+    KCMC_Instance instance(1000, 1000000, 1, 40000, 100, 150, 12345);
+    auto built = std::chrono::steady_clock::now();
+
+    SensorSet emptyset(instance.num_sensors);
+    std::unordered_map<int, int> used_sensors;
+    CheckResult coverage = instance.check_k_coverage(1, emptyset);
+    CheckResult connectivity = instance.check_m_connectivity(1, emptyset, &used_sensors);
+    auto checked = std::chrono::steady_clock::now();
+
+    std::cout << instance.key() << "\tbuild " << std::chrono::duration<double>(built - start).count()
+              << " s\tcheck " << std::chrono::duration<double>(checked - built).count()
+              << " s\tedges " << instance.sensor_sensor.num_edges()
+              << "\tpaths " << connectivity.total_paths << "\tused " << used_sensors.size() << std::endl;
+
+    bool ok = coverage.ok() and connectivity.ok() and (connectivity.total_paths >= instance.num_pois);
+    if (not ok) {
+        std::cerr << "K1M1 FAILED AT POI " << (coverage.ok() ? connectivity.failing_poi : coverage.failing_poi)
+                  << std::endl;
+    }
+    return ok ? 0 : 1;
+}
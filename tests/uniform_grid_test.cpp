@@ -0,0 +1,82 @@
+/** UNIFORM_GRID_TEST.cpp
+ * Checks the edges found through the uniform-grid spatial index against a brute-force search over every pair of
+ * nodes, including large areas with a radius of 1 (many more cells of side radius than nodes)
+ * Jose F. R. Fonseca
+ */
+
+
+// STDLib dependencies
+#include <iostream>  // cout, cerr, endl
+#include <vector>    // vector
+
+// Dependencies from this package
+#include "kcmc_instance.h"  // KCMC Instance class headers
+
+
+/* Integer equivalent of distance(source, target) <= radius */
+static bool near(const Placement &source, const Placement &target, const int radius) {
+    long long dx = source.x - target.x, dy = source.y - target.y;
+    return (dx*dx + dy*dy) <= ((long long)radius * radius);
+}
+
+
+/* Compares each row of the adjacency with the brute-force row, returning the number of edges (-1 if any row differs) */
+static long long check_adjacency(const CSR_Adjacency &adjacency, const std::vector<Placement> &sources,
+                                 const std::vector<Placement> &targets, const int radius, const bool self) {
+    long long edges = 0;
+    std::vector<int> expected;
+    for (int source=0; source < (int)sources.size(); source++) {
+        expected.clear();
+        for (int target=0; target < (int)targets.size(); target++) {
+            if ((not (self and (source == target))) and near(sources[source], targets[target], radius)) {
+                expected.push_back(target);
+            }
+        }
+        Neighbors row = adjacency[source];
+        if (std::vector<int>(row.begin(), row.end()) != expected) {return -1;}
+        edges += (long long)expected.size();
+    }
+    return edges;
+}
+
+
+/* Builds the instance and checks all of its adjacencies. Returns if they all match */
+static bool check_instance(const int num_pois, const int num_sensors, const int num_sinks, const int area_side,
+                           const int coverage_radius, const int communication_radius, const long long seed) {
+    KCMC_Instance instance(num_pois, num_sensors, num_sinks, area_side, coverage_radius, communication_radius, seed);
+    std::vector<Placement> pois(num_pois), sensors(num_sensors), sinks(num_sinks);
+    instance.get_placements(pois.data(), sensors.data(), sinks.data());
+
+    long long results[5] = {
+        check_adjacency(instance.poi_sensor, pois, sensors, coverage_radius, false),
+        check_adjacency(instance.sensor_poi, sensors, pois, coverage_radius, false),
+        check_adjacency(instance.sensor_sensor, sensors, sensors, communication_radius, true),
+        check_adjacency(instance.sensor_sink, sensors, sinks, communication_radius, false),
+        check_adjacency(instance.sink_sensor, sinks, sensors, communication_radius, false)
+    };
+    bool ok = true;
+    for (const long long &result : results) {ok = ok and (result >= 0);}
+    std::cout << instance.key() << "\t" << (ok ? "OK" : "MISMATCH") << "\t" << results[0] << " " << results[2]
+              << " " << results[3] << std::endl;
+    return ok;
+}
+
+
+int main() {
+    bool ok = true;
+
+    // Usual instances, where the cells are as large as the radius
+    ok = check_instance(100, 300, 1, 300, 50, 100, 263183180) and ok;
+    ok = check_instance(200, 500, 3, 1000, 60, 90, 4242) and ok;
+
+    // Large areas with a radius of 1, where the cells grow to keep about as many cells as nodes
+    for (const int &area_side : {20000, 50000, 100000}) {
+        ok = check_instance(50, 2000, 1, area_side, 1, 1, 42) and ok;
+    }
+
+    // Dense nodes with a radius of 1, where some of the nodes do meet
+    ok = check_instance(500, 2000, 2, 40, 1, 1, 7) and ok;
+
+    if (not ok) {std::cerr << "UNIFORM GRID EDGES DIFFER FROM THE BRUTE-FORCE SEARCH" << std::endl;}
+    return ok ? 0 : 1;
+}